@@ -325,6 +325,15 @@ public class Client implements INetwork, Runnable {
                     Platform.runLater(() -> reqCannotJoinGame());
                     break;
 
+                case "ping":
+                    if (tokens.length <= 2) {
+                        doDefault = true;
+                        break;
+                    }
+                    // Answer right away from the receiving thread, the server measures the round trip time.
+                    sendMessage(new Message("pong;" + tokens[2])); // Token message.
+                    break;
+
                 default:
                     doDefault = true;
             }
@@ -0,0 +1,602 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include "constants.h"
+#include "structs.h"
+#include "admin.h"
+#include "server.h"
+#include "memory.h"
+#include "message.h"
+#include "metrics.h"
+#include "reactor.h"
+#include "scheduler.h"
+#include "player.h"
+#include "game.h"
+#include "table.h"
+
+int a_socket = -1;
+pthread_t a_thread;
+char a_path[sizeof(((struct sockaddr_un *) 0)->sun_path)];
+
+// Strands which copy connections of each reactor on the reactor thread.
+strand_t a_strand_list[REACTOR_THREAD_COUNT];
+
+// Number of the last dump.
+long a_epoch = 0;
+
+char *a_state_names[] = {"waiting", "on_turn", "reveal", "over"};
+
+/// Start listening for admin commands on the Unix domain socket. Only the owner of the server may connect.
+/// \param path     Path of the socket. A stale socket of the path is replaced.
+/// \return         Status code. 0 = Success, 1 = Error.
+int admin_init(char *path) {
+    struct sockaddr_un local_addr;
+    int i;
+
+    if (strlen(path) >= sizeof(local_addr.sun_path))
+        return 1;
+
+    a_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (a_socket < 0)
+        return 1;
+
+    memset(&local_addr, 0, sizeof(struct sockaddr_un));
+    local_addr.sun_family = AF_UNIX;
+    strcpy(local_addr.sun_path, path);
+    strcpy(a_path, path);
+
+    unlink(path);
+
+    for (i = 0; i < g_reactor_count; ++i)
+        scheduler_strand_init(&a_strand_list[i], i);
+
+    if (bind(a_socket, (struct sockaddr *) &local_addr, sizeof(struct sockaddr_un))
+        || chmod(path, S_IRUSR | S_IWUSR)
+        || listen(a_socket, ADMIN_BACKLOG)
+        || pthread_create(&a_thread, NULL, _admin_serve, NULL)) {
+        close(a_socket);
+        a_socket = -1;
+        unlink(path);
+
+        for (i = 0; i < g_reactor_count; ++i)
+            scheduler_strand_destroy(&a_strand_list[i]);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/// Answer commands one by one. Each connection sends one command line and gets the JSON dump back.
+/// It runs in its own thread, game events and connections are copied by their own threads, so nothing waits for the dump.
+/// \param arg      Unused.
+void *_admin_serve(void *arg) {
+    int client_socket;
+    char command[64];
+    char *answer = NULL;
+    ssize_t length;
+    struct timeval timeout = {ADMIN_TIMEOUT, 0};
+
+    for (;;) {
+        client_socket = accept(a_socket, NULL, NULL);
+        if (client_socket < 0) {
+            if (__atomic_load_n(&a_socket, __ATOMIC_ACQUIRE) < 0)
+                break;
+            continue;
+        }
+
+        setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        length = recv(client_socket, command, sizeof(command) - 1, 0);
+        if (length >= 0) {
+            command[length] = '\0';
+            command[strcspn(command, "\r\n")] = '\0';
+
+            answer = _admin_command(command);
+            _metrics_send(client_socket, answer, strlen(answer));
+            memory_free(answer, 0);
+        }
+
+        close(client_socket);
+    }
+
+    return NULL;
+}
+
+/// Build the answer of the command.
+/// \param command  "players", "games", "sockets", "memory" or "all", which is the default.
+/// \return         The JSON answer. It has to be freed by memory_free.
+char *_admin_command(char *command) {
+    int is_all = !*command || strcmp(command, "all") == 0;
+    admin_dump_t dump;
+    message_t message;
+
+    message_init(&message, 4096);
+
+    if (!is_all && strcmp(command, "players") && strcmp(command, "games") && strcmp(command, "sockets")
+        && strcmp(command, "memory")) {
+        message_append(&message, "{\"error\":\"unknown command\"}\n", 28);
+        return message_finish(&message);
+    }
+
+    pthread_mutex_init(&dump.mutex, NULL);
+    pthread_cond_init(&dump.condition, NULL);
+    dump.pending = 0;
+    dump.epoch = ++a_epoch;
+
+    message_append(&message, "{\"epoch\":", 9);
+    message_append_int(&message, dump.epoch);
+    message_append(&message, ",\"time\":", 8);
+    message_append_int(&message, (long) time(NULL));
+
+    if (is_all || strcmp(command, "players") == 0)
+        _admin_players(&message);
+    if (is_all || strcmp(command, "games") == 0)
+        _admin_games(&message, &dump);
+    if (is_all || strcmp(command, "sockets") == 0)
+        _admin_sockets(&message, &dump);
+    if (is_all || strcmp(command, "memory") == 0)
+        _admin_memory(&message);
+
+    message_append(&message, "}\n", 2);
+
+    pthread_cond_destroy(&dump.condition);
+    pthread_mutex_destroy(&dump.mutex);
+
+    return message_finish(&message);
+}
+
+/// Wait until all copies posted for the dump are released. Strands run or release each posted task, so it always ends.
+/// \param dump     The dump.
+void _admin_wait(admin_dump_t *dump) {
+    pthread_mutex_lock(&dump->mutex);
+    while (dump->pending > 0)
+        pthread_cond_wait(&dump->condition, &dump->mutex);
+    pthread_mutex_unlock(&dump->mutex);
+}
+
+/// A copy posted for the dump is released.
+/// \param dump     The dump.
+void _admin_done(admin_dump_t *dump) {
+    pthread_mutex_lock(&dump->mutex);
+    if (--dump->pending == 0)
+        pthread_cond_signal(&dump->condition);
+    pthread_mutex_unlock(&dump->mutex);
+}
+
+/// Release the copy task. The records stay with the admin thread.
+/// \param task     The task.
+void _admin_release_task(task_t *task) {
+    admin_dump_t *dump = (admin_dump_t *) task->owner;
+
+    if (task->run == _admin_copy_game)
+        game_release(((admin_game_t *) task->data)->game);
+
+    memory_free(task, 0);
+    _admin_done(dump);
+}
+
+/// Append the string as a JSON string. Nicknames come from clients, so everything is escaped.
+/// \param message  The message.
+/// \param data     The string.
+void _admin_append_string(message_t *message, const char *data) {
+    char escaped[8];
+
+    message_append_char(message, '"');
+
+    for (; *data; ++data) {
+        if (*data == '"' || *data == '\\') {
+            message_append_char(message, '\\');
+            message_append_char(message, *data);
+        } else if ((unsigned char) *data < 0x20) {
+            sprintf(escaped, "\\u%04x", (unsigned char) *data);
+            message_append(message, escaped, 6);
+        } else {
+            message_append_char(message, *data);
+        }
+    }
+
+    message_append_char(message, '"');
+}
+
+/// Append the name of the field of a JSON object.
+/// \param message  The message.
+/// \param name     The name.
+/// \param is_first 1 = The first field of the object.
+void _admin_append_field(message_t *message, const char *name, int is_first) {
+    if (!is_first)
+        message_append_char(message, ',');
+    _admin_append_string(message, name);
+    message_append_char(message, ':');
+}
+
+/// Append all players. The table lock is taken only to collect references, each player is copied under its own mutex.
+/// \param message  The message.
+void _admin_players(message_t *message) {
+    unsigned int index = 0;
+    int i;
+    int count;
+    player_t *ptr = NULL;
+    player_t **players = NULL;
+    admin_player_t *copies = NULL;
+    admin_player_t *copy = NULL;
+
+    pthread_rwlock_rdlock(&g_player_table_lock);
+
+    count = g_player_table.count;
+    if (count)
+        players = memory_malloc(sizeof(player_t *) * count, 0);
+
+    for (i = 0; i < count && (ptr = table_iterate(&g_player_table, &index)); ++i) {
+        player_hold(ptr);
+        players[i] = ptr;
+    }
+    count = i;
+
+    pthread_rwlock_unlock(&g_player_table_lock);
+
+    if (count)
+        copies = memory_malloc(sizeof(admin_player_t) * count, 0);
+
+    for (i = 0; i < count; ++i) {
+        ptr = players[i];
+        copy = &copies[i];
+
+        strcpy(copy->id, ptr->id);
+        strcpy(copy->nickname, ptr->nickname);
+        strcpy(copy->client_addr, ptr->client_addr);
+
+        pthread_mutex_lock(&ptr->mutex);
+        strcpy(copy->game_id, ptr->game ? ptr->game->id : "");
+        copy->is_disconnected = ptr->is_disconnected;
+        copy->is_connected = ptr->connection != NULL;
+        copy->is_lost = ptr->lost_at != 0;
+        copy->is_removed = ptr->is_removed;
+        pthread_mutex_unlock(&ptr->mutex);
+
+        player_release(ptr);
+    }
+
+    memory_free(players, 0);
+
+    // The answer is built with no reference and no lock taken.
+    message_append(message, ",\"players\":[", 12);
+
+    for (i = 0; i < count; ++i) {
+        copy = &copies[i];
+
+        message_append(message, i ? ",{" : "{", i ? 2 : 1);
+        _admin_append_field(message, "id", 1);
+        _admin_append_string(message, copy->id);
+        _admin_append_field(message, "nickname", 0);
+        _admin_append_string(message, copy->nickname);
+        _admin_append_field(message, "address", 0);
+        _admin_append_string(message, copy->client_addr);
+        _admin_append_field(message, "game", 0);
+        if (*copy->game_id)
+            _admin_append_string(message, copy->game_id);
+        else
+            message_append(message, "null", 4);
+        _admin_append_field(message, "connected", 0);
+        message_append_int(message, copy->is_connected);
+        _admin_append_field(message, "disconnected", 0);
+        message_append_int(message, copy->is_disconnected);
+        _admin_append_field(message, "lost", 0);
+        message_append_int(message, copy->is_lost);
+        _admin_append_field(message, "removed", 0);
+        message_append_int(message, copy->is_removed);
+        message_append_char(message, '}');
+    }
+
+    message_append_char(message, ']');
+
+    memory_free(copies, 0);
+}
+
+/// Copy the game. It runs on the strand of the game between its events, so the round state is consistent.
+/// \param task     The copy task.
+void _admin_copy_game(task_t *task) {
+    admin_game_t *copy = (admin_game_t *) task->data;
+    game_t *game = copy->game;
+    player_t *player = NULL;
+    int i;
+
+    strcpy(copy->id, game->id);
+    strcpy(copy->name, game->name);
+    copy->goal = game->goal;
+    copy->state = game->state;
+    copy->in_progress = game->in_progress;
+    copy->is_open = game->is_open;
+    copy->player_count = game->player_count;
+
+    for (i = 0; i < PLAYER_COUNT; ++i) {
+        player = game->players[i];
+
+        strcpy(copy->seats[i].id, player ? player->id : "");
+        copy->seats[i].score = player ? player->score : 0;
+        copy->seats[i].choice = player ? player->choice : 0;
+    }
+
+    copy->is_copied = 1;
+}
+
+/// Append all games. Each game is copied by its own strand, the table lock is taken only to collect references.
+/// \param message  The message.
+/// \param dump     The dump.
+void _admin_games(message_t *message, admin_dump_t *dump) {
+    unsigned int index = 0;
+    int i, j;
+    int count;
+    int is_first = 1;
+    game_t *ptr = NULL;
+    admin_game_t *copies = NULL;
+    admin_game_t *copy = NULL;
+    task_t *task = NULL;
+
+    pthread_rwlock_rdlock(&g_game_table_lock);
+
+    count = g_game_table.count;
+    if (count)
+        copies = memory_malloc(sizeof(admin_game_t) * count, 0);
+
+    for (i = 0; i < count && (ptr = table_iterate(&g_game_table, &index)); ++i) {
+        game_hold(ptr);
+        copies[i].game = ptr;
+        copies[i].is_copied = 0;
+    }
+    count = i;
+
+    pthread_rwlock_unlock(&g_game_table_lock);
+
+    dump->pending += count;
+
+    for (i = 0; i < count; ++i) {
+        task = memory_malloc(sizeof(task_t), 0);
+        task->run = _admin_copy_game;
+        task->release = _admin_release_task;
+        task->owner = dump;
+        task->data = &copies[i];
+
+        scheduler_post(&copies[i].game->strand, task);
+    }
+
+    _admin_wait(dump);
+
+    message_append(message, ",\"games\":[", 10);
+
+    for (i = 0; i < count; ++i) {
+        copy = &copies[i];
+
+        // The game was freed before its strand got to it.
+        if (!copy->is_copied)
+            continue;
+
+        message_append(message, is_first ? "{" : ",{", is_first ? 1 : 2);
+        is_first = 0;
+
+        _admin_append_field(message, "id", 1);
+        _admin_append_string(message, copy->id);
+        _admin_append_field(message, "name", 0);
+        _admin_append_string(message, copy->name);
+        _admin_append_field(message, "goal", 0);
+        message_append_int(message, copy->goal);
+        _admin_append_field(message, "state", 0);
+        _admin_append_string(message, a_state_names[copy->state]);
+        _admin_append_field(message, "in_progress", 0);
+        message_append_int(message, copy->in_progress);
+        _admin_append_field(message, "open", 0);
+        message_append_int(message, copy->is_open);
+        _admin_append_field(message, "player_count", 0);
+        message_append_int(message, copy->player_count);
+        _admin_append_field(message, "seats", 0);
+        message_append_char(message, '[');
+
+        for (j = 0; j < PLAYER_COUNT; ++j) {
+            if (j)
+                message_append_char(message, ',');
+
+            if (!*copy->seats[j].id) {
+                message_append(message, "null", 4);
+                continue;
+            }
+
+            message_append_char(message, '{');
+            _admin_append_field(message, "player", 1);
+            _admin_append_string(message, copy->seats[j].id);
+            _admin_append_field(message, "score", 0);
+            message_append_int(message, copy->seats[j].score);
+            _admin_append_field(message, "choice", 0);
+            message_append_int(message, copy->seats[j].choice);
+            message_append_char(message, '}');
+        }
+
+        message_append(message, "]}", 2);
+    }
+
+    message_append_char(message, ']');
+
+    memory_free(copies, 0);
+}
+
+/// Copy connections of the reactor. It runs on the reactor thread, which is the only one removing its connections.
+/// \param task     The copy task.
+void _admin_copy_sockets(task_t *task) {
+    admin_reactor_t *copy = (admin_reactor_t *) task->data;
+    reactor_t *reactor = copy->reactor;
+    connection_t *connection = NULL;
+    admin_socket_t *socket = NULL;
+    long count;
+
+    // Connections accepted from now on are pushed in front of the head, they are not part of the copy.
+    pthread_mutex_lock(&reactor->mutex);
+    connection = reactor->connection_list;
+    count = reactor->connection_count;
+    pthread_mutex_unlock(&reactor->mutex);
+
+    if (count)
+        copy->sockets = memory_malloc(sizeof(admin_socket_t) * count, 0);
+
+    for (copy->count = 0; connection && copy->count < count; connection = connection->next) {
+        socket = &copy->sockets[copy->count++];
+
+        socket->socket = connection->socket;
+        strcpy(socket->client_address, connection->client_address);
+        socket->state = connection->state;
+        socket->protocol = connection->protocol;
+        socket->accepted_at = connection->accepted_at;
+        socket->last_activity = connection->last_activity;
+
+        // The connection holds its player while the mutex is locked, another reactor may remove the player meanwhile.
+        pthread_mutex_lock(&connection->output_mutex);
+        strcpy(socket->player_id, connection->player ? connection->player->id : "");
+        socket->output_length = connection->output_length;
+        socket->is_broken = connection->is_broken;
+        socket->has_pong = connection->has_pong;
+        socket->ping_misses = connection->ping_misses;
+        socket->rtt_smoothed = connection->rtt_smoothed;
+        pthread_mutex_unlock(&connection->output_mutex);
+    }
+}
+
+/// Append connections of all reactors. Each reactor copies its own connections.
+/// \param message  The message.
+/// \param dump     The dump.
+void _admin_sockets(message_t *message, admin_dump_t *dump) {
+    admin_reactor_t copies[REACTOR_THREAD_COUNT];
+    admin_socket_t *socket = NULL;
+    task_t *task = NULL;
+    long i;
+    int r;
+    int is_first = 1;
+
+    dump->pending += g_reactor_count;
+
+    for (r = 0; r < g_reactor_count; ++r) {
+        copies[r].reactor = &g_reactor_list[r];
+        copies[r].sockets = NULL;
+        copies[r].count = 0;
+
+        task = memory_malloc(sizeof(task_t), 0);
+        task->run = _admin_copy_sockets;
+        task->release = _admin_release_task;
+        task->owner = dump;
+        task->data = &copies[r];
+
+        scheduler_post(&a_strand_list[r], task);
+    }
+
+    _admin_wait(dump);
+
+    message_append(message, ",\"sockets\":[", 12);
+
+    for (r = 0; r < g_reactor_count; ++r) {
+        for (i = 0; i < copies[r].count; ++i) {
+            socket = &copies[r].sockets[i];
+
+            message_append(message, is_first ? "{" : ",{", is_first ? 1 : 2);
+            is_first = 0;
+
+            _admin_append_field(message, "socket", 1);
+            message_append_int(message, socket->socket);
+            _admin_append_field(message, "reactor", 0);
+            message_append_int(message, r);
+            _admin_append_field(message, "address", 0);
+            _admin_append_string(message, socket->client_address);
+            _admin_append_field(message, "player", 0);
+            if (*socket->player_id)
+                _admin_append_string(message, socket->player_id);
+            else
+                message_append(message, "null", 4);
+            _admin_append_field(message, "state", 0);
+            _admin_append_string(message, socket->state == CONNECTION_HANDSHAKE ? "handshake" : "active");
+            _admin_append_field(message, "protocol", 0);
+            _admin_append_string(message, socket->protocol == PROTOCOL_BINARY ? "binary" : "text");
+            _admin_append_field(message, "queued_bytes", 0);
+            message_append_int(message, (long) socket->output_length);
+            _admin_append_field(message, "broken", 0);
+            message_append_int(message, socket->is_broken);
+            _admin_append_field(message, "accepted_at", 0);
+            message_append_int(message, (long) socket->accepted_at);
+            _admin_append_field(message, "last_activity", 0);
+            message_append_int(message, (long) socket->last_activity);
+            _admin_append_field(message, "rtt_us", 0);
+            if (socket->has_pong)
+                message_append_int(message, socket->rtt_smoothed);
+            else
+                message_append(message, "null", 4);
+            _admin_append_field(message, "ping_misses", 0);
+            message_append_int(message, socket->ping_misses);
+            message_append_char(message, '}');
+        }
+
+        memory_free(copies[r].sockets, 0);
+    }
+
+    message_append_char(message, ']');
+}
+
+/// Append the status of the allocator. Counters of threads are read without stopping them.
+/// \param message  The message.
+void _admin_memory(message_t *message) {
+    long allocations[MEMORY_CLASS_COUNT + 1];
+    long frees[MEMORY_CLASS_COUNT + 1];
+    long total = 0;
+    int c;
+
+    _memory_sum(allocations, frees);
+
+    message_append(message, ",\"memory\":{\"classes\":[", 22);
+
+    for (c = 0; c <= MEMORY_CLASS_COUNT; ++c) {
+        total += allocations[c] - frees[c];
+
+        message_append(message, c ? ",{" : "{", c ? 2 : 1);
+        _admin_append_field(message, "size", 1);
+        if (c < MEMORY_CLASS_COUNT)
+            message_append_int(message, (long) _memory_class_size(c));
+        else
+            _admin_append_string(message, "large");
+        _admin_append_field(message, "allocations", 0);
+        message_append_int(message, allocations[c]);
+        _admin_append_field(message, "in_use", 0);
+        message_append_int(message, allocations[c] - frees[c]);
+        message_append_char(message, '}');
+    }
+
+    message_append_char(message, ']');
+    _admin_append_field(message, "in_use", 0);
+    message_append_int(message, total);
+    _admin_append_field(message, "slab_bytes", 0);
+    message_append_int(message, memory_slab_bytes());
+    message_append_char(message, '}');
+}
+
+/// Stop answering commands and remove the socket.
+void admin_free() {
+    int socket = __atomic_exchange_n(&a_socket, -1, __ATOMIC_ACQ_REL);
+    int i;
+
+    if (socket < 0)
+        return;
+
+    // Wake the thread blocked in accept.
+    shutdown(socket, SHUT_RDWR);
+    pthread_join(a_thread, NULL);
+    close(socket);
+    unlink(a_path);
+
+    for (i = 0; i < g_reactor_count; ++i)
+        scheduler_strand_destroy(&a_strand_list[i]);
+}
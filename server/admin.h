@@ -0,0 +1,24 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_ADMIN_H
+#define SERVER_ADMIN_H
+
+int admin_init(char *path);
+void *_admin_serve(void *arg);
+char *_admin_command(char *command);
+void _admin_wait(admin_dump_t *dump);
+void _admin_done(admin_dump_t *dump);
+void _admin_release_task(task_t *task);
+void _admin_append_string(message_t *message, const char *data);
+void _admin_append_field(message_t *message, const char *name, int is_first);
+void _admin_players(message_t *message);
+void _admin_copy_game(task_t *task);
+void _admin_games(message_t *message, admin_dump_t *dump);
+void _admin_copy_sockets(task_t *task);
+void _admin_sockets(message_t *message, admin_dump_t *dump);
+void _admin_memory(message_t *message);
+void admin_free();
+
+#endif //SERVER_ADMIN_H
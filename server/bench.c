@@ -0,0 +1,404 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "constants.h"
+#include "structs.h"
+#include "token_hash.h"
+#include "parser.h"
+#include "memory.h"
+#include "server.h"
+#include "game.h"
+#include "game_logic.h"
+#include "lobby.h"
+#include "buffer.h"
+#include "colors.h"
+#include "id.h"
+
+#define BENCH_GAME_COUNT 4096 // Games the game benchmarks go round.
+#define BENCH_LOBBY_GAME_COUNT 1000 // Open games listed in the lobby.
+#define BENCH_GOAL 3
+#define BENCH_MAX_ITERATIONS 1000000000L
+#define BENCH_FRAME_SIZE 64
+
+typedef struct thebench {
+    char *name;
+    void (*run)(long count);
+} bench_t;
+
+game_t *b_games[BENCH_GAME_COUNT];
+game_t *b_lobby_games[BENCH_LOBBY_GAME_COUNT];
+
+// Requests as clients send them. Splitting is in place, so each one is copied first.
+char *b_lines[] = {
+        "0ff8ffae5420f202;game_choice_selected;2;",
+        "0ff8ffae5420f202;get_games;",
+        "0ff8ffae5420f202;join_player_to_game;88b87061bfe31100;",
+        "0ff8ffae5420f202;lobby_subscribe;822;",
+};
+#define BENCH_LINE_COUNT (int) (sizeof(b_lines) / sizeof(b_lines[0]))
+
+unsigned char b_frames[BENCH_LINE_COUNT][BENCH_FRAME_SIZE];
+unsigned int b_frame_lengths[BENCH_LINE_COUNT];
+
+long b_min_time = 200; // Milliseconds each benchmark runs at least.
+char *b_filter = NULL;
+FILE *b_output = NULL;
+volatile long b_sink = 0; // Results are stored here, so the compiler does not drop the work.
+
+/// Nanoseconds between the times.
+/// \param from     The earlier time.
+/// \param to       The later time.
+/// \return         The nanoseconds.
+long _bench_elapsed(struct timespec *from, struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1000000000L + (to->tv_nsec - from->tv_nsec);
+}
+
+/// Count of allocations made so far by the memory module.
+/// \return         The count.
+long _bench_allocations() {
+    long allocations[MEMORY_CLASS_COUNT + 1];
+    long frees[MEMORY_CLASS_COUNT + 1];
+    long total = 0;
+    int c;
+
+    _memory_sum(allocations, frees);
+
+    for (c = 0; c <= MEMORY_CLASS_COUNT; ++c)
+        total += allocations[c];
+
+    return total;
+}
+
+/// Write the value as a varint, as the binary protocol does.
+/// \param data     Where it is written.
+/// \param value    The value.
+/// \return         Written bytes.
+unsigned int _bench_varint(unsigned char *data, unsigned long value) {
+    unsigned int size = 0;
+
+    while (value >= 0x80) {
+        data[size++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    data[size++] = (unsigned char) value;
+
+    return size;
+}
+
+/// Encode the text request as a binary frame without its length prefix.
+/// \param line     The request.
+/// \param frame    Where the frame is written.
+/// \return         Length of the frame.
+unsigned int _bench_frame(char *line, unsigned char *frame) {
+    char copy[REQUEST_STORAGE_SIZE];
+    request_t request;
+    unsigned int length = 0;
+    int i;
+
+    snprintf(copy, sizeof(copy), "%s", line);
+    parser_split(copy, (unsigned int) strlen(copy), &request);
+
+    frame[length++] = (unsigned char) request.command;
+    length += _bench_varint(frame + length, strtoul(request.tokens[0].data, NULL, 16));
+
+    // IDs are hexadecimal, the rest are numbers.
+    for (i = 2; i < request.count; ++i)
+        length += _bench_varint(frame + length, strtoul(request.tokens[i].data, NULL, request.tokens[i].length == ID_LENGTH ? 16 : 10));
+
+    return length;
+}
+
+/// Create a game which is not registered anywhere.
+/// \param player_count     Count of its players.
+/// \return                 The game.
+game_t *_bench_game(int player_count) {
+    game_t *game = memory_malloc(sizeof(game_t), 0);
+    player_t *player = NULL;
+    int i;
+
+    memset(game, 0, sizeof(game_t));
+    id_generate(game->id);
+    strcpy(game->name, "game-");
+    strcat(game->name, game->id);
+    game->goal = BENCH_GOAL;
+    game->reference_count = 1;
+
+    for (i = 0; i < player_count; ++i) {
+        player = memory_malloc(sizeof(player_t), 0);
+        memset(player, 0, sizeof(player_t));
+        id_generate(player->id);
+        player->nickname_length = snprintf(player->nickname, sizeof(player->nickname), "player-%d", i);
+        player->color = g_color_list[i];
+        player->reference_count = 1;
+        pthread_mutex_init(&player->mutex, NULL);
+
+        game->players[i] = player;
+        game->player_count++;
+    }
+
+    return game;
+}
+
+/// Destroy the game created by _bench_game.
+/// \param game     The game.
+void _bench_game_destroy(game_t *game) {
+    int i;
+
+    for (i = 0; i < PLAYER_COUNT; ++i) {
+        if (!game->players[i])
+            continue;
+        pthread_mutex_destroy(&game->players[i]->mutex);
+        memory_free(game->players[i], 0);
+    }
+
+    memory_free(game, 0);
+}
+
+/// Create the synthetic games, the lobby and the frames.
+void _bench_init() {
+    int i;
+
+    id_init();
+    colors_init();
+    game_init();
+
+    for (i = 0; i < BENCH_GAME_COUNT; ++i)
+        b_games[i] = _bench_game(PLAYER_COUNT);
+
+    // Each open game waits for its second player.
+    pthread_rwlock_wrlock(&g_game_table_lock);
+    for (i = 0; i < BENCH_LOBBY_GAME_COUNT; ++i) {
+        b_lobby_games[i] = _bench_game(1);
+        _game_open_add(b_lobby_games[i]);
+    }
+    pthread_rwlock_unlock(&g_game_table_lock);
+
+    for (i = 0; i < BENCH_LINE_COUNT; ++i)
+        b_frame_lengths[i] = _bench_frame(b_lines[i], b_frames[i]);
+}
+
+/// Free the synthetic data.
+void _bench_free() {
+    int i;
+
+    pthread_rwlock_wrlock(&g_game_table_lock);
+    for (i = 0; i < BENCH_LOBBY_GAME_COUNT; ++i)
+        _game_open_remove(b_lobby_games[i]);
+    pthread_rwlock_unlock(&g_game_table_lock);
+
+    for (i = 0; i < BENCH_LOBBY_GAME_COUNT; ++i)
+        _bench_game_destroy(b_lobby_games[i]);
+    for (i = 0; i < BENCH_GAME_COUNT; ++i)
+        _bench_game_destroy(b_games[i]);
+
+    game_free();
+    colors_free();
+}
+
+/// Compare all pairs of choices.
+/// \param count    Iterations.
+void _bench_compare_choices(long count) {
+    long sum = 0;
+    long i;
+
+    for (i = 0; i < count; ++i)
+        sum += _game_logic_compare_choices((choice_t) (i % 3 + 1), (choice_t) (i / 3 % 3 + 1));
+
+    b_sink += sum;
+}
+
+/// Score rounds of different games.
+/// \param count    Iterations.
+void _bench_count_score(long count) {
+    game_t *game = NULL;
+    long i;
+
+    for (i = 0; i < count; ++i) {
+        game = b_games[i % BENCH_GAME_COUNT];
+        game->players[0]->choice = (int) (i % 3 + 1);
+        game->players[1]->choice = (int) (i / 3 % 3 + 1);
+        _game_logic_count_score(game);
+    }
+
+    b_sink += b_games[0]->players[0]->score;
+}
+
+/// Look for winners of different games. Some have none, some have one, some have two.
+/// \param count    Iterations.
+void _bench_check_winner(long count) {
+    game_t *game = NULL;
+    long i;
+
+    for (i = 0; i < count; ++i) {
+        game = b_games[i % BENCH_GAME_COUNT];
+        game->goal = BENCH_GOAL;
+        game->players[0]->score = (int) (i % (BENCH_GOAL + 1));
+        game->players[1]->score = (int) (i / 2 % (BENCH_GOAL + 1));
+        b_sink += _game_logic_check_winner(game) != NULL;
+    }
+}
+
+/// Split text requests. It includes copying the request, since splitting is in place.
+/// \param count    Iterations.
+void _bench_parser_split(long count) {
+    char copy[REQUEST_STORAGE_SIZE];
+    request_t request;
+    char *line = NULL;
+    size_t length;
+    long i;
+
+    for (i = 0; i < count; ++i) {
+        line = b_lines[i % BENCH_LINE_COUNT];
+        length = strlen(line);
+        memcpy(copy, line, length + 1);
+        b_sink += parser_split(copy, (unsigned int) length, &request);
+    }
+}
+
+/// Decode binary frames of the same requests.
+/// \param count    Iterations.
+void _bench_parser_decode(long count) {
+    request_t request;
+    long i;
+
+    for (i = 0; i < count; ++i)
+        b_sink += parser_decode((char *) b_frames[i % BENCH_LINE_COUNT], b_frame_lengths[i % BENCH_LINE_COUNT], &request);
+}
+
+/// Build the player list of different games. Players have no connection, so nothing is sent.
+/// \param count    Iterations.
+void _bench_update_players(long count) {
+    long i;
+
+    for (i = 0; i < count; ++i)
+        game_send_update_players(b_games[i % BENCH_GAME_COUNT]);
+}
+
+/// Copy the snapshot of the long lobby, as a get_games does.
+/// \param count    Iterations.
+void _bench_lobby_snapshot(long count) {
+    buffer_t *snapshot = NULL;
+    long version;
+    long i;
+
+    for (i = 0; i < count; ++i) {
+        snapshot = lobby_snapshot(&version);
+        b_sink += (long) snapshot->length;
+        buffer_release(snapshot);
+    }
+}
+
+/// Close the first game of the long lobby and open it again at the end. All the other entries move.
+/// \param count    Iterations.
+void _bench_lobby_reopen(long count) {
+    game_t *game = NULL;
+    long i;
+
+    for (i = 0; i < count; ++i) {
+        pthread_rwlock_wrlock(&g_game_table_lock);
+        game = g_game_open_list;
+        _game_open_remove(game);
+        _game_open_add(game);
+        pthread_rwlock_unlock(&g_game_table_lock);
+    }
+
+    b_sink += g_lobby_version;
+}
+
+bench_t b_benches[] = {
+        {"compare_choices", _bench_compare_choices},
+        {"count_score", _bench_count_score},
+        {"check_winner", _bench_check_winner},
+        {"parser_split", _bench_parser_split},
+        {"parser_decode", _bench_parser_decode},
+        {"update_players", _bench_update_players},
+        {"lobby_snapshot", _bench_lobby_snapshot},
+        {"lobby_reopen", _bench_lobby_reopen},
+};
+
+/// Run the benchmark with more and more iterations until it takes the minimal time, then print its result as a JSON line.
+/// \param bench    The benchmark.
+void _bench_run(bench_t *bench) {
+    struct timespec start, end;
+    long count = 1;
+    long next;
+    long elapsed = 0;
+    long allocations = 0;
+
+    for (;;) {
+        allocations = _bench_allocations();
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bench->run(count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        allocations = _bench_allocations() - allocations;
+        elapsed = _bench_elapsed(&start, &end);
+
+        if (elapsed >= b_min_time * 1000000L || count >= BENCH_MAX_ITERATIONS)
+            break;
+
+        // Aim a bit above the minimal time by the rate so far, but do not grow too fast on a noisy start.
+        next = elapsed > 0 ? (long) ((double) count * (double) b_min_time * 1200000.0 / (double) elapsed) : count * 100;
+        count = next > count * 100 ? count * 100 : next > count ? next : count + 1;
+    }
+
+    fprintf(b_output, "{\"benchmark\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.2f,\"allocs_per_op\":%.2f}\n",
+            bench->name, count, (double) elapsed / (double) count, (double) allocations / (double) count);
+    fflush(b_output);
+}
+
+/// Print the usage.
+/// \param name     Name of the program.
+void _bench_usage(char *name) {
+    printf("Usage: %s [-t milliseconds] [-f name]\n", name);
+    printf("\t-t\tMinimal time of each benchmark.\n");
+    printf("\t-f\tRun only benchmarks whose name contains the text.\n");
+}
+
+/// Run the benchmarks. Each result is a line of JSON on the standard output.
+/// \param argv -
+/// \param args -
+/// \return Status code of success.
+int main(int argv, char *args[]) {
+    int option;
+    int i;
+
+    while ((option = getopt(argv, args, "t:f:")) != -1) {
+        switch (option) {
+            case 't': b_min_time = atol(optarg); break;
+            case 'f': b_filter = optarg; break;
+            default:
+                _bench_usage(args[0]);
+                return 1;
+        }
+    }
+
+    if (b_min_time < 1) {
+        _bench_usage(args[0]);
+        return 1;
+    }
+
+    // The server prints what it sends, results go to the original output only.
+    b_output = fdopen(dup(STDOUT_FILENO), "w");
+    if (!b_output || !freopen("/dev/null", "w", stdout)) {
+        fprintf(stderr, "\t> Output: ERROR!\n");
+        return 1;
+    }
+
+    _bench_init();
+
+    for (i = 0; i < (int) (sizeof(b_benches) / sizeof(b_benches[0])); ++i)
+        if (!b_filter || strstr(b_benches[i].name, b_filter))
+            _bench_run(&b_benches[i]);
+
+    _bench_free();
+    fclose(b_output);
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include "constants.h"
+#include "structs.h"
+#include "buffer.h"
+#include "memory.h"
+
+/// Create a buffer holding a copy of the data. The buffer must not be changed once it is shared.
+/// \param data     The data.
+/// \param length   Length of the data.
+/// \return         The buffer with a single reference.
+buffer_t *buffer_create(const char *data, size_t length) {
+    buffer_t *buffer = memory_malloc(offsetof(buffer_t, data) + length + 1, 0);
+
+    buffer->reference_count = 1;
+    buffer->length = length;
+    memcpy(buffer->data, data, length);
+    buffer->data[length] = '\0';
+
+    return buffer;
+}
+
+/// Create a buffer holding the formatted text.
+/// \param format   The format (as for printf).
+/// \return         The buffer with a single reference.
+buffer_t *buffer_format(const char *format, ...) {
+    buffer_t *buffer = NULL;
+    va_list arguments;
+    int length;
+
+    va_start(arguments, format);
+    length = vsnprintf(NULL, 0, format, arguments);
+    va_end(arguments);
+
+    if (length < 0)
+        length = 0;
+
+    buffer = memory_malloc(offsetof(buffer_t, data) + (size_t) length + 1, 0);
+    buffer->reference_count = 1;
+    buffer->length = (size_t) length;
+
+    va_start(arguments, format);
+    vsnprintf(buffer->data, (size_t) length + 1, format, arguments);
+    va_end(arguments);
+
+    return buffer;
+}
+
+/// Take a reference of the buffer.
+/// \param buffer   The buffer.
+void buffer_hold(buffer_t *buffer) {
+    __atomic_fetch_add(&buffer->reference_count, 1, __ATOMIC_RELAXED);
+}
+
+/// Drop the reference of the buffer. The last one frees it.
+/// \param buffer   The buffer or NULL.
+void buffer_release(buffer_t *buffer) {
+    if (!buffer || __atomic_sub_fetch(&buffer->reference_count, 1, __ATOMIC_ACQ_REL) > 0)
+        return;
+
+    memory_free(buffer, 0);
+}
@@ -0,0 +1,13 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_BUFFER_H
+#define SERVER_BUFFER_H
+
+buffer_t *buffer_create(const char *data, size_t length);
+buffer_t *buffer_format(const char *format, ...);
+void buffer_hold(buffer_t *buffer);
+void buffer_release(buffer_t *buffer);
+
+#endif //SERVER_BUFFER_H
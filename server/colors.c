@@ -6,6 +6,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include "constants.h"
+#include "structs.h"
 #include "colors.h"
 #include "memory.h"
 
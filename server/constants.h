@@ -5,8 +5,58 @@
 #define PLAYER_COUNT 2
 #define GOAL_DEFAULT 3
 #define TIMEOUT_LOST_CONN 120
+#define TIMEOUT_LOST_HEARTBEAT 15 // Seconds a player evicted by the heartbeat may reconnect, before its seat is given up.
 #define TIMEOUT_UNSUCCESSFUL 5
+#define TIMEOUT_IDLE 60
+#define TIMEOUT_HANDSHAKE 5 // Seconds a new connection has to send its handshake.
+#define HEARTBEAT_INTERVAL 5000 // Milliseconds between a pong and the next ping.
+#define HEARTBEAT_JITTER 1000 // Milliseconds the interval is randomly shifted by, so pings of many connections do not come at once.
+#define HEARTBEAT_TIMEOUT_MIN 1000 // Bounds of the adaptive timeout of a ping, in milliseconds.
+#define HEARTBEAT_TIMEOUT_MAX 10000
+#define HEARTBEAT_MISSES 2 // Unanswered pings in a row after which the peer is considered dead.
+#define REACTOR_THREAD_COUNT 64 // The most reactors started, one per core the server may run on.
+#define REACTOR_LISTENERS 1 // 1 = Each reactor accepts on its own SO_REUSEPORT listener, 0 = One thread accepts for all reactors.
+#define GAME_REVEAL_DELAY 1000 // Milliseconds.
+#define TIMER_TICK 10 // Milliseconds.
+#define TIMER_SLOT_BITS 6
+#define TIMER_LEVEL_COUNT 4
+#define REACTOR_MAX_EVENTS 64
+#define REACTOR_ACCEPT_BATCH 64 // Connections accepted at once, then the reactor serves its other events first.
+#define LISTEN_BACKLOG 1024 // Connections the kernel queues until they are accepted, capped by net.core.somaxconn.
+#define CONNECTION_LIMIT 100000 // Open connections, more are closed right after accept. Lowered to fit the open file limit.
+#define HANDSHAKE_LIMIT 1024 // Connections of a reactor waiting for their handshake, more are closed right after accept.
+#define CONNECTION_OUTPUT_LIMIT 262144 // Bytes queued for a client, which does not read, before it is disconnected.
+#define CONNECTION_IOV_COUNT 64
+#define RECEIVE_BUFFER_SIZE 1024 // Must be a power of 2.
 #define MAX_CLIENT_TOKENS 5
+#define REQUEST_STORAGE_SIZE (MAX_CLIENT_TOKENS * 21) // Text of fields decoded from a binary frame, each up to 20 digits.
+#define FRAME_INVALID 0xFFFFFFFFu // Size of a binary frame which can never fit into the receive buffer.
+#define FRAME_HEADER_LIMIT 3 // Bytes of the varint length of a binary frame.
+#define PROTOCOL_BINARY_OPTION "binary" // Handshake option which switches the client to binary frames.
+#define ID_LENGTH 16
+#define ID_BLOCK_SIZE 1024
+#define NICKNAME_LENGTH 49
+#define COLOR_LENGTH 6
+#define LOBBY_HISTORY_SIZE 256
+#define LOBBY_VERSION_NONE (-1)
+#define MEMORY_CLASS_SMALLEST 16
+#define MEMORY_CLASS_COUNT 9 // 16 B .. 4 kB.
+#define MEMORY_CACHE_BATCH 32
+#define MEMORY_SLAB_SIZE 65536
+#define LOGGER_RING_SIZE 1024 // Must be a power of 2.
+#define LOGGER_ENTRY_SIZE 256
+#define LOGGER_BATCH_SIZE 65536
+#define LOGGER_POLICY_DROP 0
+#define LOGGER_POLICY_BLOCK 1
+#define LOGGER_POLICY LOGGER_POLICY_DROP
+#define LOGGER_FILE "server.log"
+#define STATS_HISTOGRAM_SUB_BITS 2 // Each power of 2 is split into 4 buckets.
+#define STATS_HISTOGRAM_BUCKETS 160 // Values up to 2^40.
+#define CACHE_LINE_SIZE 64
+#define METRICS_BACKLOG 4
+#define METRICS_TIMEOUT 2
+#define ADMIN_BACKLOG 4
+#define ADMIN_TIMEOUT 2
 #define PORT_DEFAULT 10000
 #define CUSTOM_PORT_LOWEST_POSSIBLE 1
 #define CUSTOM_PORT_HIGHEST_POSSIBLE 65535
@@ -0,0 +1,161 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <string.h>
+#include <sys/uio.h>
+#include "constants.h"
+#include "structs.h"
+#include "frame.h"
+
+#define FRAME_MASK (RECEIVE_BUFFER_SIZE - 1)
+
+/// Reset the receive buffer.
+/// \param buffer   The buffer.
+void frame_init(frame_buffer_t *buffer) {
+    buffer->head = 0;
+    buffer->tail = 0;
+    buffer->scanned = 0;
+}
+
+/// Read as much data as fits into the free space of the buffer.
+/// \param buffer   The buffer.
+/// \param socket   The socket.
+/// \return         Same as recv. 0 = closed connection, -1 = unsuccessful, >0 = number of received bytes.
+int frame_recv(frame_buffer_t *buffer, int socket) {
+    struct iovec iov[2];
+    unsigned int free_space = RECEIVE_BUFFER_SIZE - (buffer->tail - buffer->head);
+    unsigned int tail = buffer->tail & FRAME_MASK;
+    unsigned int first = RECEIVE_BUFFER_SIZE - tail;
+    int iov_count = 1;
+    int read_size;
+
+    if (first > free_space)
+        first = free_space;
+
+    iov[0].iov_base = buffer->data + tail;
+    iov[0].iov_len = first;
+
+    // The free space wraps around the end of the buffer.
+    if (free_space > first) {
+        iov[1].iov_base = buffer->data;
+        iov[1].iov_len = free_space - first;
+        iov_count = 2;
+    }
+
+    read_size = (int) readv(socket, iov, iov_count);
+
+    if (read_size > 0)
+        buffer->tail += read_size;
+
+    return read_size;
+}
+
+/// Take the next complete frame out of the buffer. Frames are terminated by '\n', the terminator (and '\r' before it) is stripped.
+/// \param buffer   The buffer.
+/// \param scratch  Space for a frame which wraps around the end of the buffer. At least RECEIVE_BUFFER_SIZE + 1 chars.
+/// \param size     Where the length of the frame is written.
+/// \return         Null-terminated frame valid until the next call, or NULL if there is no complete frame.
+char *frame_next(frame_buffer_t *buffer, char *scratch, unsigned int *size) {
+    unsigned int i;
+    unsigned int start = buffer->head & FRAME_MASK;
+    unsigned int length;
+    char *frame = NULL;
+
+    if (buffer->scanned < buffer->head)
+        buffer->scanned = buffer->head;
+
+    for (i = buffer->scanned; i != buffer->tail; ++i)
+        if (buffer->data[i & FRAME_MASK] == '\n')
+            break;
+
+    if (i == buffer->tail) {
+        // Remember where to continue next time.
+        buffer->scanned = i;
+        return NULL;
+    }
+
+    length = i - buffer->head;
+
+    if (start + length < RECEIVE_BUFFER_SIZE) {
+        // Frame is contiguous, terminate it in place.
+        frame = buffer->data + start;
+    } else {
+        // Frame wraps around, copy both parts.
+        memcpy(scratch, buffer->data + start, RECEIVE_BUFFER_SIZE - start);
+        memcpy(scratch + (RECEIVE_BUFFER_SIZE - start), buffer->data, length - (RECEIVE_BUFFER_SIZE - start));
+        frame = scratch;
+    }
+
+    frame[length] = '\0';
+    if (length > 0 && frame[length - 1] == '\r')
+        frame[--length] = '\0';
+    *size = length;
+
+    buffer->head = i + 1;
+    buffer->scanned = buffer->head;
+
+    return frame;
+}
+
+/// Take the next complete binary frame out of the buffer. A frame is its length as a varint followed by that many bytes.
+/// \param buffer   The buffer.
+/// \param scratch  Space for a frame which wraps around the end of the buffer. At least RECEIVE_BUFFER_SIZE chars.
+/// \param size     Where the length of the frame (without the length prefix) is written. FRAME_INVALID if the frame can never fit into the buffer.
+/// \return         Frame valid until the next call, or NULL if there is no complete frame. It is not null-terminated.
+char *frame_next_binary(frame_buffer_t *buffer, char *scratch, unsigned int *size) {
+    unsigned int available = buffer->tail - buffer->head;
+    unsigned int header = 0;
+    unsigned int length = 0;
+    unsigned int start;
+    unsigned char byte;
+    char *frame = NULL;
+
+    do {
+        if (header == available)
+            return NULL;
+
+        if (header == FRAME_HEADER_LIMIT) {
+            *size = FRAME_INVALID;
+            return NULL;
+        }
+
+        byte = (unsigned char) buffer->data[(buffer->head + header) & FRAME_MASK];
+        length |= (unsigned int) (byte & 0x7F) << (7 * header);
+        header++;
+    } while (byte & 0x80);
+
+    if (header + length > RECEIVE_BUFFER_SIZE) {
+        *size = FRAME_INVALID;
+        return NULL;
+    }
+
+    if (available - header < length)
+        return NULL;
+
+    start = (buffer->head + header) & FRAME_MASK;
+
+    if (start + length <= RECEIVE_BUFFER_SIZE) {
+        // Frame is contiguous. It is not terminated, the next frame follows right after it.
+        frame = buffer->data + start;
+    } else {
+        // Frame wraps around, copy both parts.
+        memcpy(scratch, buffer->data + start, RECEIVE_BUFFER_SIZE - start);
+        memcpy(scratch + (RECEIVE_BUFFER_SIZE - start), buffer->data, length - (RECEIVE_BUFFER_SIZE - start));
+        frame = scratch;
+    }
+
+    *size = length;
+
+    buffer->head += header + length;
+    buffer->scanned = buffer->head;
+
+    return frame;
+}
+
+/// Check if the buffer is full of data with no complete frame (the frame is too long).
+/// \param buffer   The buffer.
+/// \return         1 = full, 0 = there is a free space.
+int frame_is_full(frame_buffer_t *buffer) {
+    return buffer->tail - buffer->head >= RECEIVE_BUFFER_SIZE;
+}
@@ -0,0 +1,14 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_FRAME_H
+#define SERVER_FRAME_H
+
+void frame_init(frame_buffer_t *buffer);
+int frame_recv(frame_buffer_t *buffer, int socket);
+char *frame_next(frame_buffer_t *buffer, char *scratch, unsigned int *size);
+char *frame_next_binary(frame_buffer_t *buffer, char *scratch, unsigned int *size);
+int frame_is_full(frame_buffer_t *buffer);
+
+#endif //SERVER_FRAME_H
@@ -14,57 +14,140 @@
 #include "stats.h"
 #include "player.h"
 #include "game_logic.h"
+#include "table.h"
+#include "id.h"
+#include "message.h"
+#include "lobby.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "buffer.h"
+#include "reactor.h"
+
+/// Key of the game in the game table.
+/// \param item     The game.
+/// \return         Game ID.
+char *_game_key_id(void *item) {
+    return ((game_t *) item)->id;
+}
 
-pthread_t thread_id;
+/// Initialize the game registry.
+void game_init() {
+    table_init(&g_game_table, _game_key_id);
+    g_game_open_list = NULL;
+    g_game_open_list_tail = NULL;
+    g_game_open_count = 0;
+    lobby_init();
+}
 
-/// Find the game in the game list.
+/// Find the game in the game list. The game is held, it has to be released by game_release.
 /// \param id       Id of the game.
 /// \return         The game struct or NULL.
 game_t *game_find(char *id) {
-    pthread_mutex_lock(&g_game_list_mutex);
+    game_t *game_ptr = NULL;
 
-    if (g_game_list != NULL) {
-        game_t *game_ptr = g_game_list;
+    pthread_rwlock_rdlock(&g_game_table_lock);
+    game_ptr = table_find(&g_game_table, id);
+    if (game_ptr)
+        game_hold(game_ptr);
+    pthread_rwlock_unlock(&g_game_table_lock);
 
-        do {
-            if (strcmp(game_ptr->id, id) == 0) {
-                pthread_mutex_unlock(&g_game_list_mutex);
-                return game_ptr;
-            }
+    return game_ptr;
+}
+
+/// Update membership of the game in the set of open (joinable) games. Call it whenever the player count changes.
+/// \param game     The game.
+void game_update_open(game_t *game) {
+    if (!game)
+        return;
+
+    pthread_rwlock_wrlock(&g_game_table_lock);
 
-            game_ptr = game_ptr->next;
+    // Only registered games can be listed.
+    if (table_find(&g_game_table, game->id) == game) {
+        if (game->player_count >= PLAYER_COUNT)
+            _game_open_remove(game);
+        else if (game->is_open)
+            lobby_game_changed(game);
+        else
+            _game_open_add(game);
 
-        } while (game_ptr != NULL);
+        _game_open_slots_update(game);
     }
 
-    pthread_mutex_unlock(&g_game_list_mutex);
+    pthread_rwlock_unlock(&g_game_table_lock);
 }
 
-/// Broadcast information about available games to all players.
-void game_broadcast_update_games() {
-    game_t *game_list_ptr = g_game_list;
-    char *message = NULL;
+/// Keep the count of free slots of open games up to date. Call it with the game table lock.
+/// \param game     The game.
+void _game_open_slots_update(game_t *game) {
+    int slots = game->is_open ? PLAYER_COUNT - game->player_count : 0;
 
-    message = memory_malloc(sizeof(char) * 1024, 0);
-    memset(message, 0, strlen(message));
-    sprintf(message, "1;update_games"); // Token message.
+    metrics_gauge_add(METRICS_GAUGE_OPEN_SLOTS, slots - game->open_slots);
+    game->open_slots = slots;
+}
 
-    pthread_mutex_lock(&g_game_list_mutex);
+/// Mark the game as (not) in progress.
+/// \param game         The game.
+/// \param in_progress  1 = in progress, 0 = not.
+/// \return             1 = The state is changed, 0 = It was already set.
+int game_set_in_progress(game_t *game, int in_progress) {
+    if (__atomic_exchange_n(&game->in_progress, in_progress, __ATOMIC_ACQ_REL) == in_progress)
+        return 0;
 
-    if (g_game_list != NULL) {
-        do {
-            if (game_list_ptr->player_count < PLAYER_COUNT)
-                sprintf(message, "%s;%s;%s;%d", message, game_list_ptr->name, game_list_ptr->id, game_list_ptr->goal);
+    metrics_gauge_add(METRICS_GAUGE_GAMES_IN_PROGRESS, in_progress ? 1 : -1);
 
-            game_list_ptr = game_list_ptr->next;
+    return 1;
+}
 
-        } while (game_list_ptr != NULL);
-    }
+/// Append the game at the end of the open game list. Call it with the game table lock.
+/// \param game     The game.
+void _game_open_add(game_t *game) {
+    if (game->is_open)
+        return;
 
-    pthread_mutex_unlock(&g_game_list_mutex);
+    game->is_open = 1;
+    game->open_next = NULL;
+    game->open_prev = g_game_open_list_tail;
 
-    strcat(message, "\n");
-    svr_broadcast(message);
+    if (g_game_open_list_tail)
+        g_game_open_list_tail->open_next = game;
+    else
+        g_game_open_list = game;
+
+    g_game_open_list_tail = game;
+    g_game_open_count++;
+
+    lobby_game_opened(game);
+}
+
+/// Unlink the game from the open game list. Call it with the game table lock.
+/// \param game     The game.
+void _game_open_remove(game_t *game) {
+    if (!game->is_open)
+        return;
+
+    lobby_game_closed(game);
+
+    if (game->open_prev)
+        game->open_prev->open_next = game->open_next;
+    else
+        g_game_open_list = game->open_next;
+
+    if (game->open_next)
+        game->open_next->open_prev = game->open_prev;
+    else
+        g_game_open_list_tail = game->open_prev;
+
+    game->is_open = 0;
+    game->open_next = NULL;
+    game->open_prev = NULL;
+    g_game_open_count--;
+}
+
+/// Broadcast information about available games to all players in the lobby.
+void game_broadcast_update_games() {
+    // The snapshot and deltas are maintained on each change of open games, no need to build them.
+    lobby_publish();
 }
 
 /// Send information about all players who playing the current game.
@@ -74,22 +157,32 @@ void game_send_update_players(game_t *game) {
         return;
 
     int i;
-    char *message = NULL;
+    message_t message;
     player_t *player = NULL;
 
-    message = memory_malloc(sizeof(char) * 1024, 0);
-    memset(message, 0, strlen(message));
-    sprintf(message, "1;update_players"); // Token message.
+    message_init_buffer(&message, 32 + PLAYER_COUNT * (ID_LENGTH + NICKNAME_LENGTH + 32));
+    message_append(&message, "1;update_players", 16); // Token message.
 
     for (i = 0; i < PLAYER_COUNT; ++i) {
         player = game->players[i];
 
-        if (player)
-            sprintf(message, "%s;%s;%s;%s;%d;%d", message, player->id, player->nickname, player->color, player->score, player->choice);
+        if (!player)
+            continue;
+
+        message_append_char(&message, ';');
+        message_append(&message, player->id, ID_LENGTH);
+        message_append_char(&message, ';');
+        message_append(&message, player->nickname, (size_t) player->nickname_length);
+        message_append_char(&message, ';');
+        message_append(&message, player->color, COLOR_LENGTH);
+        message_append_char(&message, ';');
+        message_append_int(&message, player->score);
+        message_append_char(&message, ';');
+        message_append_int(&message, player->choice);
     }
 
-    strcat(message, "\n");
-    game_multicast(game, message);
+    message_append_char(&message, '\n');
+    game_multicast(game, message_finish_buffer(&message));
 }
 
 /// Send information about state/status of the game.
@@ -100,12 +193,8 @@ void game_send_current_state_info(game_t *game) {
 
     int i;
     int state = 0;
-    char *message = NULL;
     player_t *player = NULL;
 
-    message = memory_malloc(sizeof(char) * 256, 0);
-    memset(message, 0, strlen(message));
-
     for (i = 0; i < PLAYER_COUNT; ++i) {
         if (game->players[i]) {
             player = game->players[i];
@@ -119,26 +208,24 @@ void game_send_current_state_info(game_t *game) {
         if (game->in_progress) { // If the game is in progress and there is only 1 player.
             state = 0;
 
-            sprintf(message, "%s;set_player_win;%s\n", player->id, player->nickname); // Token message.
-            game_multicast(game, message);
+            game_multicast(game, buffer_format("%s;set_player_win;%s\n", player->id, player->nickname)); // Token message.
 
             // Turn off the game.
-            game->in_progress = 0;
+            game_set_in_progress(game, 0);
 
-            // Release game semaphore.
-            sem_post(&game->sem_on_turn);
+            // Let the game finish.
+            game_post(game, GAME_EVENT_STOP, NULL, 0);
         }
     } else if (game->player_count < PLAYER_COUNT) {
         state = 1;
     }
 
     if (player != NULL && state > 0) {
-        sprintf(message, "%s;game_state;%d\n", player->id, state); // Token message.
-        game_multicast(game, message);
+        game_multicast(game, buffer_format("%s;game_state;%d\n", player->id, state)); // Token message.
     }
 }
 
-/// Creates the game.
+/// Creates the game on the scheduler shard of the creator's reactor, so its events run on the core which serves the creator.
 /// \param player       Creator of the game.
 /// \param goal         The goal.
 void game_create(player_t *player, int goal) {
@@ -146,17 +233,27 @@ void game_create(player_t *player, int goal) {
         return;
 
     int i;
+    int shard = 0;
     char *log_message = NULL;
+    connection_t *connection = player_get_connection(player);
+
+    if (connection)
+        shard = connection->reactor->index;
+    reactor_connection_release(connection);
 
     game_t *game = memory_malloc(sizeof(game_t), 0);
 
-    game->id = svr_generate_id();
+    id_generate(game->id);
 
-    game->name = memory_malloc(sizeof(char) * (19 + 5 + 1), 0);
     strcpy(game->name, "game-");
     strcat(game->name, game->id);
 
-    game->next = NULL;
+    game->is_open = 0;
+    game->open_slots = 0;
+    game->open_next = NULL;
+    game->open_prev = NULL;
+    game->lobby_offset = 0;
+    game->lobby_length = 0;
     game->player_count = 0;
 
     if (goal > 0)
@@ -164,7 +261,9 @@ void game_create(player_t *player, int goal) {
     else
         game->goal = GOAL_DEFAULT;
 
-    sem_init(&(game->sem_on_turn), 0, 0);
+    scheduler_strand_init(&game->strand, shard);
+    game->state = GAME_STATE_WAITING;
+    game->reference_count = 1; // The game table holds it.
     game->in_progress = 0;
 
     for (i = 0; i < PLAYER_COUNT; ++i)
@@ -174,34 +273,28 @@ void game_create(player_t *player, int goal) {
     sprintf(log_message, "\t> Game created (ID: %s)!\n", game->id);
     write_log(log_message);
 
+    // The join of the creator is the first event of the game, nobody may join the listed game before.
+    game_post(game, GAME_EVENT_JOIN, player, 0);
     game_add(game);
-    player_connect_to_game(player, game);
-    game_broadcast_update_games();
 
     memory_free(log_message, 0);
 }
 
-/// It adds the game to the game list.
+/// It adds the game to the game list. The game is listed as open once it has a player, see game_update_open.
 /// \param game     The game.
 void game_add(game_t *game) {
     if (!game)
         return;
 
-    pthread_mutex_lock(&g_game_list_mutex);
+    pthread_rwlock_wrlock(&g_game_table_lock);
 
-    if (g_game_list == NULL) {
-        g_game_list = game;
-    } else {
-        game_t *game_list_ptr = g_game_list;
-
-        while (game_list_ptr->next != NULL) {
-            game_list_ptr = game_list_ptr->next;
-        }
+    table_add(&g_game_table, game);
+    if (game->player_count > 0 && game->player_count < PLAYER_COUNT)
+        _game_open_add(game);
+    _game_open_slots_update(game);
+    metrics_gauge_add(METRICS_GAUGE_GAMES, 1);
 
-        game_list_ptr->next = game;
-    }
-
-    pthread_mutex_unlock(&g_game_list_mutex);
+    pthread_rwlock_unlock(&g_game_table_lock);
 }
 
 /// It removes the game from the game list.
@@ -210,47 +303,31 @@ void game_remove(game_t *game) {
     if (!game)
         return;
 
-    char *id = game->id;
-    game_t *ptr = NULL;
-    game_t *previous = NULL;
+    int is_removed = 0;
     char *log_message = NULL;
 
-    ptr = g_game_list;
-
     log_message = memory_malloc(sizeof(char) * 256, 0);
     sprintf(log_message, "\t> Game removed (ID: %s)!\n", game->id);
 
-    pthread_mutex_lock(&g_game_list_mutex);
-
-    do {
-        if (strcmp(ptr->id, id) == 0) {
-            if (!previous) {
-                if (ptr->next == NULL) {
-                    _game_destroy(ptr);
-                    g_game_list = NULL;
-                } else {
-                    g_game_list = ptr->next;
-                    _game_destroy(ptr);
-                    ptr = NULL;
-                }
-            } else {
-                previous->next = ptr->next;
-                _game_destroy(ptr);
-                ptr = NULL;
-            }
-        }
+    pthread_rwlock_wrlock(&g_game_table_lock);
 
-        if (ptr) {
-            previous = ptr;
-            ptr = ptr->next;
-        }
+    if (table_remove(&g_game_table, game)) {
+        _game_open_remove(game);
+        _game_open_slots_update(game);
+        metrics_gauge_add(METRICS_GAUGE_GAMES, -1);
+        is_removed = 1;
+    }
 
-    } while (ptr);
+    pthread_rwlock_unlock(&g_game_table_lock);
 
-    pthread_mutex_unlock(&g_game_list_mutex);
+    // The game has been already removed by someone else.
+    if (is_removed) {
+        game_set_in_progress(game, 0);
+        game_release(game);
 
-    write_log(log_message);
-    game_broadcast_update_games();
+        write_log(log_message);
+        game_broadcast_update_games();
+    }
 
     memory_free(log_message, 0);
 }
@@ -261,82 +338,235 @@ void _game_destroy(game_t *game) {
     if (!game)
         return;
 
-    memory_free(game->id, 0);
-    memory_free(game->name, 0);
-    sem_destroy(&(game->sem_on_turn));
+    scheduler_strand_destroy(&game->strand);
     memory_free(game, 0);
 }
 
-/// Start the game thread.
+/// Start the game. Rounds are driven by events handled by the scheduler, no thread is dedicated to the game.
 /// \param game     The game.
 /// \return         Status code. 0 = success. 1 = error.
 int game_start(game_t *game) {
-    char *log_message = NULL;
-
-    thread_id = 0;
-
-    if (!game || pthread_create(&thread_id, NULL, _game_serve, (void *) game)) {
-        // Log.
-        log_message = memory_malloc(sizeof(char) * 256, 0);
-        sprintf(log_message, "\t> Fatal ERROR during creating a new thread!\n");
-        write_log(log_message);
-        memory_free(log_message, 0);
+    if (!game)
         return 1;
-    }
 
-    game->thread = thread_id;
-    game->in_progress = 1;
+    // Players joining at the same time may both see the game full, only the first one starts it.
+    if (game_set_in_progress(game, 1))
+        game_post(game, GAME_EVENT_ROUND_START, NULL, 0);
 
     return 0;
 }
 
-/// Send message to all players of the game.
+/// Send message to all players of the game. All of them share the same buffer.
 /// \param game         The game.
-/// \param message      The message.
-void game_multicast(game_t *game, char *message) {
-    if (!game || !message)
+/// \param buffer       The message. The reference is taken over.
+void game_multicast(game_t *game, buffer_t *buffer) {
+    if (!game || !buffer) {
+        buffer_release(buffer);
         return;
+    }
 
     int i;
 
-    printf(ANSI_COLOR_BLUE "--->>> (BC/g)\t %s" ANSI_COLOR_RESET, message);
+    printf(ANSI_COLOR_BLUE "--->>> (BC/g)\t %s" ANSI_COLOR_RESET, buffer->data);
 
     for (i = 0; i < PLAYER_COUNT; ++i)
         if (game->players[i] && game->players[i]->is_disconnected != 1)
-            svr_send(game->players[i]->socket, message, 1);
+            player_send_buffer(game->players[i], buffer, 0, 1);
 
-    memory_free(message, 0);
+    buffer_release(buffer);
+}
+
+/// Take a reference to the game. The game is destroyed when the last reference is released.
+/// \param game     The game.
+void game_hold(game_t *game) {
+    __atomic_fetch_add(&game->reference_count, 1, __ATOMIC_RELAXED);
+}
+
+/// Release the reference to the game.
+/// \param game     The game or NULL.
+void game_release(game_t *game) {
+    if (game && __atomic_sub_fetch(&game->reference_count, 1, __ATOMIC_ACQ_REL) == 0)
+        _game_destroy(game);
+}
+
+/// Post the event to the game. Events of a game are handled one by one by the reactor of its shard.
+/// \param game     The game.
+/// \param event    The event.
+/// \param player   The player the event comes from or NULL.
+/// \param value    Value of the event.
+void game_post(game_t *game, game_event_t event, player_t *player, long value) {
+    _game_post(game, event, player, value, 0);
+}
+
+/// Post the event to the game after the delay.
+/// \param game     The game.
+/// \param event    The event.
+/// \param delay    The delay in milliseconds.
+void game_post_delayed(game_t *game, game_event_t event, long delay) {
+    _game_post(game, event, NULL, 0, delay);
 }
 
-/// Serve the game.
-/// \param arg      The args.
-/// \return         -
-void *_game_serve(void *arg) {
-    if (!arg)
-        return NULL;
+/// Create the task of the event. The task keeps the game and the player alive until it is released.
+/// \param game     The game.
+/// \param event    The event.
+/// \param player   The player the event comes from or NULL.
+/// \param value    Value of the event.
+/// \param delay    The delay in milliseconds or 0.
+void _game_post(game_t *game, game_event_t event, player_t *player, long value, long delay) {
+    if (!game)
+        return;
+
+    task_t *task = memory_malloc(sizeof(task_t), 0);
+
+    task->run = _game_handle;
+    task->release = _game_release_task;
+    task->owner = game;
+    task->event = event;
+    task->data = player;
+    task->value = value;
+
+    game_hold(game);
+    if (player)
+        player_hold(player);
+
+    if (delay > 0)
+        scheduler_post_delayed(&game->strand, task, delay);
+    else
+        scheduler_post(&game->strand, task);
+}
+
+/// Release the task of the event.
+/// \param task     The task.
+void _game_release_task(task_t *task) {
+    player_release((player_t *) task->data);
+    game_release((game_t *) task->owner);
+    memory_free(task, 0);
+}
+
+/// Handle the event. The game moves between waiting for choices, revealing the round and being over.
+/// Players join and leave by events as well, so only the strand of the game touches its players.
+/// \param task     The task of the event.
+void _game_handle(task_t *task) {
+    game_t *game = (game_t *) task->owner;
+    player_t *player = (player_t *) task->data;
+
+    switch ((game_event_t) task->event) {
+        case GAME_EVENT_ROUND_START:
+            // The round being revealed starts the next one by itself.
+            if (game->state != GAME_STATE_REVEAL && game->state != GAME_STATE_OVER)
+                _game_round_start(game);
+            break;
+
+        case GAME_EVENT_CHOICE:
+            // The round is not evaluated once a player left, the slot of the player is empty until the game stops.
+            if (game->state != GAME_STATE_ON_TURN || game->player_count != PLAYER_COUNT || !_game_has_player(game, player))
+                break;
+
+            if (game_logic_apply_turn(game, player, (int) task->value)) {
+                // Give players time to see the result of the round.
+                game->state = GAME_STATE_REVEAL;
+                game_post_delayed(game, GAME_EVENT_ROUND_EVALUATED, GAME_REVEAL_DELAY);
+            }
+            break;
+
+        case GAME_EVENT_ROUND_EVALUATED:
+            if (game->state != GAME_STATE_REVEAL)
+                break;
 
-    game_t *game = NULL;
+            game_multicast(game, _game_message("1;do_after_turn\n")); // Token message.
+            _game_round_start(game);
+            break;
+
+        case GAME_EVENT_STOP:
+            if (game->state != GAME_STATE_OVER && (!game->in_progress || game->player_count < PLAYER_COUNT))
+                _game_finish(game);
+            break;
+
+        case GAME_EVENT_JOIN:
+            if (game->state != GAME_STATE_OVER && !player_connect_to_game(player, game))
+                break;
+
+            game_refuse_player(player);
+
+            // The creator may have joined another game meanwhile, nobody is going to play this one.
+            if (game->state != GAME_STATE_OVER && game->player_count == 0) {
+                game->state = GAME_STATE_OVER;
+                game_remove(game);
+            }
+            break;
+
+        case GAME_EVENT_LEAVE:
+            if (_game_has_player(game, player))
+                player_disconnect_from_game(player, game);
+            break;
+    }
+}
+
+/// Tell the player it cannot join the game. Removed players are not told anything.
+/// \param player   The player.
+void game_refuse_player(player_t *player) {
     char *message = NULL;
 
-    game = (game_t *) arg;
+    if (!player || __atomic_load_n(&player->is_removed, __ATOMIC_ACQUIRE))
+        return;
 
-    while (game->in_progress && game->player_count == PLAYER_COUNT) {
-        for (int i = 0; i < game->player_count; ++i) {
-            game_logic_prepare_player_turn(game->players[i]);
-            // Update player data.
-            game_send_update_players(game);
+    message = memory_malloc(sizeof(char) * 256, 0);
+    sprintf(message, "%s;cannot_join_game\n", player->id); // Token message.
+    player_send(player, message, 0);
+    memory_free(message, 0);
+}
 
-            message = memory_malloc(sizeof(char) * 256, 0);
-            memset(message, 0, strlen(message));
-            sprintf(message, "%s;on_turn\n", game->players[i]->id);
-            svr_send(game->players[i]->socket, message, 0);
-            memory_free(message, 0);
-        }
+/// Copy the message into a buffer, so it can be sent by game_multicast.
+/// \param text     The message.
+/// \return         The buffer.
+buffer_t *_game_message(char *text) {
+    return buffer_create(text, strlen(text));
+}
+
+/// Check if the player is still in the game.
+/// \param game     The game.
+/// \param player   The player.
+/// \return         1 = The player is in the game, 0 = Not.
+int _game_has_player(game_t *game, player_t *player) {
+    int i;
+
+    for (i = 0; i < PLAYER_COUNT; ++i)
+        if (player && game->players[i] == player)
+            return 1;
+
+    return 0;
+}
 
-        // Wait until all players play.
-        sem_wait(&game->sem_on_turn);
+/// Start a new round, or finish the game if it is over or a player is missing.
+/// \param game     The game.
+void _game_round_start(game_t *game) {
+    char *message = NULL;
+
+    if (!game->in_progress || game->player_count != PLAYER_COUNT) {
+        _game_finish(game);
+        return;
     }
 
+    for (int i = 0; i < game->player_count; ++i) {
+        game_logic_prepare_player_turn(game->players[i]);
+        // Update player data.
+        game_send_update_players(game);
+
+        message = memory_malloc(sizeof(char) * 256, 0);
+        memset(message, 0, strlen(message));
+        sprintf(message, "%s;on_turn\n", game->players[i]->id);
+        player_send(game->players[i], message, 0);
+        memory_free(message, 0);
+    }
+
+    game->state = GAME_STATE_ON_TURN;
+}
+
+/// Finish the game and disconnect all players. The last one leaving removes the game.
+/// \param game     The game.
+void _game_finish(game_t *game) {
+    game->state = GAME_STATE_OVER;
+
     // Disconnect all players.
     for (int j = 0; j < PLAYER_COUNT; ++j) {
         if (!game->player_count)
@@ -345,31 +575,50 @@ void *_game_serve(void *arg) {
         player_disconnect_from_game(game->players[j], game);
     }
 
-    game->in_progress = 0;
-
-    return NULL;
+    game_set_in_progress(game, 0);
 }
 
 /// Free all games.
 void game_free() {
-    while (g_game_list) {
-        game_remove(g_game_list);
-    }
+    int i;
+    int count;
+    unsigned int index = 0;
+    game_t *ptr = NULL;
+    game_t **games = NULL;
+
+    pthread_rwlock_rdlock(&g_game_table_lock);
+
+    count = g_game_table.count;
+    if (count)
+        games = memory_malloc(sizeof(game_t *) * count, 0);
+
+    for (i = 0; i < count && (ptr = table_iterate(&g_game_table, &index)); ++i)
+        games[i] = ptr;
+
+    pthread_rwlock_unlock(&g_game_table_lock);
+
+    for (i = 0; i < count; ++i)
+        game_remove(games[i]);
+
+    memory_free(games, 0);
+
+    table_free(&g_game_table);
+    lobby_free();
 }
 
 /// Print the game.
 void game_print() {
-    game_t *ptr = g_game_list;
+    unsigned int index = 0;
+    game_t *ptr = NULL;
 
     printf("========== GAME LIST ==========\n");
 
-    if (g_game_list) {
-        do {
-            printf("Name: %s (ID: %s)\n", ptr->name, ptr->id);
-            ptr = ptr->next;
+    pthread_rwlock_rdlock(&g_game_table_lock);
 
-        } while (ptr);
-    }
+    while ((ptr = table_iterate(&g_game_table, &index)))
+        printf("Name: %s (ID: %s)\n", ptr->name, ptr->id);
+
+    pthread_rwlock_unlock(&g_game_table_lock);
 
     printf("===============================\n");
 }
\ No newline at end of file
@@ -5,7 +5,14 @@
 #ifndef SERVER_GAME_H
 #define SERVER_GAME_H
 
+char *_game_key_id(void *item);
+void game_init();
 game_t *game_find(char *id);
+void game_update_open(game_t *game);
+void _game_open_slots_update(game_t *game);
+int game_set_in_progress(game_t *game, int in_progress);
+void _game_open_add(game_t *game);
+void _game_open_remove(game_t *game);
 void game_broadcast_update_games();
 void game_send_update_players(game_t *game);
 void game_send_current_state_info(game_t *game);
@@ -14,8 +21,19 @@ void game_add(game_t *game);
 void game_remove(game_t *game);
 void _game_destroy(game_t *game);
 int game_start(game_t *game);
-void game_multicast(game_t *game, char *message);
-void *_game_serve(void *arg);
+void game_multicast(game_t *game, buffer_t *buffer);
+void game_hold(game_t *game);
+void game_release(game_t *game);
+void game_post(game_t *game, game_event_t event, player_t *player, long value);
+void game_post_delayed(game_t *game, game_event_t event, long delay);
+void _game_post(game_t *game, game_event_t event, player_t *player, long value, long delay);
+void _game_release_task(task_t *task);
+void _game_handle(task_t *task);
+void game_refuse_player(player_t *player);
+buffer_t *_game_message(char *text);
+int _game_has_player(game_t *game, player_t *player);
+void _game_round_start(game_t *game);
+void _game_finish(game_t *game);
 void game_free();
 void game_print();
 
@@ -5,28 +5,29 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <unistd.h>
 #include "structs.h"
 #include "game_logic.h"
 #include "memory.h"
 #include "stats.h"
 #include "game.h"
+#include "player.h"
 #include "constants.h"
 #include "server.h"
+#include "buffer.h"
 
 /// Evalutate game after turn.
 /// \param g        The game.
-void _game_logic_evaluate(game_t *g) {
+/// \return         1 = The round is evaluated, 0 = Some player has not chosen yet.
+int _game_logic_evaluate(game_t *g) {
     if (!g)
-        return;
+        return 0;
 
-    char *message = NULL;
     player_t *p = NULL;
 
     // Check if all players already have selected their choice.
     for (int i = 0; i < g->player_count; ++i)
         if (!g->players[i]->choice)
-            return;
+            return 0;
 
     // All players selected their choices.
     // Count score.
@@ -34,36 +35,40 @@ void _game_logic_evaluate(game_t *g) {
 
     // Check winner.
     if ((p =_game_logic_check_winner(g))) {
-        message = memory_malloc(sizeof(char) * 256, 0);
-        sprintf(message, "%s;set_player_win;%s\n", p->id, p->nickname); // Token message.
-        game_multicast(g, message);
+        game_multicast(g, buffer_format("%s;set_player_win;%s\n", p->id, p->nickname)); // Token message.
 
         // Turn off the game.
-        g->in_progress = 0;
+        game_set_in_progress(g, 0);
     }
 
     // Update player data.
     game_send_update_players(g);
 
-    // Sleep due to client-friendly interaction.
-    sleep(1);
-
-    message = memory_malloc(sizeof(char) * 256, 0);
-    memset(message, 0, strlen(message));
-    sprintf(message, "1;do_after_turn\n"); // Token message.
-    game_multicast(g, message);
-
-    // Release game semaphore.
-    sem_post(&g->sem_on_turn);
+    return 1;
 }
 
-/// Check player's turn.
+/// Pass player's turn to the game. It is recorded when the game handles it.
 /// \param p        The player.
 /// \param c        It's choice.
 void game_logic_record_turn(player_t *p, int c) {
-    if (!p)
+    game_t *g = NULL;
+
+    if (!p || !(g = player_get_game(p)))
         return;
 
+    game_post(g, GAME_EVENT_CHOICE, p, c);
+    game_release(g);
+}
+
+/// Record player's turn and evaluate the round. Call it from the game events only.
+/// \param g        The game.
+/// \param p        The player.
+/// \param c        It's choice.
+/// \return         1 = The round is evaluated, 0 = Some player has not chosen yet.
+int game_logic_apply_turn(game_t *g, player_t *p, int c) {
+    if (!g || !p)
+        return 0;
+
     if (c == ROCK)
         p->choice = ROCK;
     else if (c == PAPER)
@@ -72,7 +77,7 @@ void game_logic_record_turn(player_t *p, int c) {
         p->choice = SCISSORS;
 
     // Evaluate game round.
-    _game_logic_evaluate(p->game);
+    return _game_logic_evaluate(g);
 }
 
 /// Prepare player to a new turn.
@@ -5,8 +5,9 @@
 #ifndef SERVER_GAME_LOGIC_H
 #define SERVER_GAME_LOGIC_H
 
-void _game_logic_evaluate(game_t *g);
+int _game_logic_evaluate(game_t *g);
 void game_logic_record_turn(player_t *p, int c);
+int game_logic_apply_turn(game_t *g, player_t *p, int c);
 void game_logic_prepare_player_turn(player_t *p);
 void game_logic_prepare_player_on_game_join(player_t *p);
 void _game_logic_count_score(game_t *g);
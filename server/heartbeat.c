@@ -0,0 +1,191 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "constants.h"
+#include "structs.h"
+#include "heartbeat.h"
+#include "timer.h"
+#include "reactor.h"
+#include "server.h"
+#include "stats.h"
+#include "memory.h"
+
+// Seed of the jitter. The timer thread and each reactor have their own, so no random state is shared between threads.
+static __thread unsigned int h_seed = 0;
+
+/// Monotonic time in microseconds.
+/// \return         The time.
+long _heartbeat_now() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000L + now.tv_nsec / 1000;
+}
+
+/// Delay until the next ping. It is randomly shifted by up to HEARTBEAT_JITTER both ways.
+/// \return         The delay in milliseconds.
+long _heartbeat_interval() {
+    if (!h_seed)
+        h_seed = (unsigned int) (_heartbeat_now() ^ (long) &h_seed) | 1;
+
+    return HEARTBEAT_INTERVAL - HEARTBEAT_JITTER + rand_r(&h_seed) % (2 * HEARTBEAT_JITTER + 1);
+}
+
+/// How long to wait for the pong, by the round trip times measured so far. The same estimate TCP uses (RFC 6298).
+/// Call it with the output mutex.
+/// \param connection   The connection.
+/// \return             The timeout in milliseconds.
+long _heartbeat_timeout(connection_t *connection) {
+    long timeout = (connection->rtt_smoothed + 4 * connection->rtt_variance) / 1000;
+
+    if (timeout < HEARTBEAT_TIMEOUT_MIN)
+        return HEARTBEAT_TIMEOUT_MIN;
+    if (timeout > HEARTBEAT_TIMEOUT_MAX)
+        return HEARTBEAT_TIMEOUT_MAX;
+
+    return timeout;
+}
+
+/// Initialize the heartbeat of the new connection. Pings are not sent until it is started.
+/// \param connection   The connection.
+void heartbeat_init(connection_t *connection) {
+    timer_entry_init(&connection->heartbeat_timer, _heartbeat_expired, connection);
+    connection->ping_sequence = 0;
+    connection->ping_sent_at = 0;
+    connection->ping_misses = 0;
+    connection->has_pong = 0;
+    connection->is_evicted = 0;
+    connection->rtt_smoothed = 0;
+    connection->rtt_variance = 0;
+}
+
+/// Start pinging the connection. Called once the handshake is done. All connections share the timer thread, no thread waits per connection.
+/// \param connection   The connection.
+void heartbeat_start(connection_t *connection) {
+    pthread_mutex_lock(&connection->output_mutex);
+
+    if (!connection->is_closed && !timer_is_pending(&connection->heartbeat_timer)) {
+        reactor_connection_hold(connection);
+        timer_schedule(&connection->heartbeat_timer, _heartbeat_interval());
+    }
+
+    pthread_mutex_unlock(&connection->output_mutex);
+}
+
+/// Stop pinging the closed connection. The reference of the pending timer is dropped.
+/// A timer already firing sees the connection closed and drops the reference by itself.
+/// \param connection   The connection.
+void heartbeat_stop(connection_t *connection) {
+    if (timer_cancel(&connection->heartbeat_timer))
+        reactor_connection_release(connection);
+}
+
+/// Send the next ping, or count the unanswered one. A peer which misses HEARTBEAT_MISSES pings in a row is shut down,
+/// the reactor then closes it as a lost connection. Its player may reconnect for TIMEOUT_LOST_HEARTBEAT seconds only, then its seat is freed.
+/// It runs on the timer thread, so it must not block.
+/// \param timer    Heartbeat timer of the connection.
+void _heartbeat_expired(timer_entry_t *timer) {
+    connection_t *connection = (connection_t *) timer->data;
+    char *log_message = NULL;
+    char message[64];
+    unsigned long sequence;
+
+    pthread_mutex_lock(&connection->output_mutex);
+
+    if (connection->is_closed || connection->is_broken) {
+        pthread_mutex_unlock(&connection->output_mutex);
+        reactor_connection_release(connection);
+        return;
+    }
+
+    if (connection->ping_sent_at && connection->has_pong && ++connection->ping_misses >= HEARTBEAT_MISSES) {
+        connection->is_evicted = 1;
+        _reactor_output_break(connection);
+        pthread_mutex_unlock(&connection->output_mutex);
+
+        stats_add(STATS_HEARTBEAT_EVICTIONS, 1);
+
+        // Log.
+        log_message = memory_malloc(sizeof(char) * 256, 0);
+        sprintf(log_message, "\t> Connection of %s does not answer pings, evicted!\n", connection->client_address);
+        write_log(log_message);
+        memory_free(log_message, 0);
+
+        reactor_connection_release(connection);
+        return;
+    }
+
+    sequence = ++connection->ping_sequence;
+    connection->ping_sent_at = _heartbeat_now();
+
+    // A peer which never answered may not know pings at all, it is pinged at the regular interval only.
+    timer_schedule(&connection->heartbeat_timer, connection->has_pong ? _heartbeat_timeout(connection) : _heartbeat_interval());
+
+    // The timer keeps its reference, but it may be cancelled as soon as the mutex is unlocked.
+    reactor_connection_hold(connection);
+    pthread_mutex_unlock(&connection->output_mutex);
+
+    sprintf(message, "1;ping;%lu\n", sequence); // Token message.
+    svr_send(connection, message, 0);
+
+    reactor_connection_release(connection);
+}
+
+/// Tell, if the connection was shut down by the heartbeat.
+/// \param connection   The connection.
+/// \return             1 = Evicted, 0 = Otherwise.
+int heartbeat_is_evicted(connection_t *connection) {
+    int is_evicted;
+
+    pthread_mutex_lock(&connection->output_mutex);
+    is_evicted = connection->is_evicted;
+    pthread_mutex_unlock(&connection->output_mutex);
+
+    return is_evicted;
+}
+
+/// The peer answered the ping. Update its round trip time and schedule the next ping.
+/// \param connection   The connection.
+/// \param sequence     Sequence number of the answered ping.
+/// \return             Status code. 0 = Success, 1 = It does not answer the last ping.
+int heartbeat_pong(connection_t *connection, unsigned long sequence) {
+    long rtt;
+    long error;
+
+    pthread_mutex_lock(&connection->output_mutex);
+
+    if (connection->is_closed || !connection->ping_sent_at || sequence != connection->ping_sequence) {
+        pthread_mutex_unlock(&connection->output_mutex);
+        return 1;
+    }
+
+    rtt = _heartbeat_now() - connection->ping_sent_at;
+    connection->ping_sent_at = 0;
+    connection->ping_misses = 0;
+
+    if (!connection->has_pong) {
+        connection->rtt_smoothed = rtt;
+        connection->rtt_variance = rtt / 2;
+        connection->has_pong = 1;
+    } else {
+        error = connection->rtt_smoothed - rtt;
+        connection->rtt_variance = (3 * connection->rtt_variance + (error < 0 ? -error : error)) / 4;
+        connection->rtt_smoothed = (7 * connection->rtt_smoothed + rtt) / 8;
+    }
+
+    // Wait for the next ping instead of the pong. If the timer is firing right now, it sends the ping by itself.
+    if (timer_cancel(&connection->heartbeat_timer))
+        timer_schedule(&connection->heartbeat_timer, _heartbeat_interval());
+
+    pthread_mutex_unlock(&connection->output_mutex);
+
+    stats_heartbeat_rtt(rtt);
+
+    return 0;
+}
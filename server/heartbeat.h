@@ -0,0 +1,18 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_HEARTBEAT_H
+#define SERVER_HEARTBEAT_H
+
+long _heartbeat_now();
+long _heartbeat_interval();
+long _heartbeat_timeout(connection_t *connection);
+void heartbeat_init(connection_t *connection);
+void heartbeat_start(connection_t *connection);
+void heartbeat_stop(connection_t *connection);
+void _heartbeat_expired(timer_entry_t *timer);
+int heartbeat_is_evicted(connection_t *connection);
+int heartbeat_pong(connection_t *connection, unsigned long sequence);
+
+#endif //SERVER_HEARTBEAT_H
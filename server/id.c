@@ -0,0 +1,62 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/random.h>
+#include "constants.h"
+#include "id.h"
+
+// Key of the permutation, randomly chosen at the start of the server.
+unsigned long i_key[4];
+
+// Next free sequence number. Threads take it in blocks of ID_BLOCK_SIZE.
+unsigned long i_sequence = 0;
+
+// Sequence numbers reserved by the current thread.
+static __thread unsigned long i_block_next = 0;
+static __thread unsigned long i_block_end = 0;
+
+/// Choose a random key of the ID permutation.
+void id_init() {
+    int i;
+
+    if (getrandom(i_key, sizeof(i_key), 0) != sizeof(i_key)) {
+        // Not as good, but still not guessable from outside.
+        srand((unsigned int) (time(NULL) ^ getpid()));
+
+        for (i = 0; i < 4; ++i)
+            i_key[i] = ((unsigned long) rand() << 32) ^ (unsigned long) rand();
+    }
+}
+
+/// Keyed bijection of 64-bit numbers. Every step is invertible, so different sequence numbers never collide.
+/// \param sequence     The sequence number.
+/// \return             The permuted number.
+unsigned long _id_permute(unsigned long sequence) {
+    int i;
+    unsigned long x = sequence;
+
+    for (i = 0; i < 4; ++i) {
+        x ^= i_key[i];
+        x *= 0x9E3779B97F4A7C15UL; // Odd multiplier.
+        x ^= x >> 29;
+    }
+
+    return x;
+}
+
+/// Generates unique ID for players and game instances. Does not need any lookup or lock.
+/// \param id       Buffer of ID_LENGTH + 1 chars.
+void id_generate(char *id) {
+    if (i_block_next == i_block_end) {
+        // Sequence 0 is skipped, so no ID is ever the permutation of the initial value.
+        i_block_next = __atomic_fetch_add(&i_sequence, ID_BLOCK_SIZE, __ATOMIC_RELAXED) + 1;
+        i_block_end = i_block_next + ID_BLOCK_SIZE;
+    }
+
+    sprintf(id, "%016lx", _id_permute(i_block_next++));
+}
@@ -0,0 +1,12 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_ID_H
+#define SERVER_ID_H
+
+void id_init();
+unsigned long _id_permute(unsigned long sequence);
+void id_generate(char *id);
+
+#endif //SERVER_ID_H
@@ -0,0 +1,743 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "token_hash.h"
+
+#define LOADGEN_INPUT_SIZE 16384
+#define LOADGEN_OUTPUT_SIZE 256
+#define LOADGEN_MAX_EVENTS 256
+#define LOADGEN_TICK 10 // Milliseconds the thread waits for messages before it checks the rate and the end.
+#define LOADGEN_DRAIN_TIMEOUT 2000000 // Microseconds to wait for the server to close connections at the end.
+#define LOADGEN_HISTOGRAM_SUB_BITS 2 // Each power of 2 is split into 4 buckets.
+#define LOADGEN_HISTOGRAM_BUCKETS 160 // Values up to 2^40.
+
+typedef struct theloadhistogram {
+    long count;
+    long max;
+    long buckets[LOADGEN_HISTOGRAM_BUCKETS];
+} loadgen_histogram_t;
+
+typedef struct theloadclient {
+    int socket;
+    int is_closed;
+    int index; // Index in the pair. The first client creates games, the second one joins them.
+    char id[32];
+    unsigned long id_value;
+    int is_in_game;
+    int is_on_turn;
+    int is_pending[TOKEN_COUNT]; // Requests waiting for their answer, by the command.
+    struct timespec sent_at[TOKEN_COUNT];
+    int is_skipping; // The line does not fit into the input, the rest of it is thrown away.
+    size_t input_length;
+    char input[LOADGEN_INPUT_SIZE];
+    struct theloadpair *pair;
+} loadgen_client_t;
+
+typedef struct theloadpair {
+    loadgen_client_t clients[2];
+    unsigned long game_value;
+    int is_waiting; // Both clients are on turn, the round waits for the rate.
+} loadgen_pair_t;
+
+typedef struct theloadthread {
+    pthread_t thread;
+    int index;
+    int epoll_fd;
+    loadgen_pair_t *pairs;
+    int pair_count;
+    int waiting_count;
+    double tokens; // Rounds the thread may play now by the rate.
+    struct timespec refilled_at;
+    unsigned int seed;
+    long games;
+    long rounds;
+    long errors;
+    loadgen_histogram_t latency[TOKEN_COUNT];
+} loadgen_thread_t;
+
+const char *const g_token_names[TOKEN_COUNT] = TOKEN_NAMES;
+
+// Kinds of the fields of requests, as the server decodes binary frames. 'i' = ID, 'n' = number.
+const char *const g_token_fields[TOKEN_COUNT] = {
+        [TOKEN_LOBBY_SUBSCRIBE] = "n",
+        [TOKEN_CREATE_NEW_GAME] = "n",
+        [TOKEN_JOIN_PLAYER_TO_GAME] = "i",
+        [TOKEN_DISCONNECT_PLAYER_FROM_GAME] = "i",
+        [TOKEN_GAME_CHOICE_SELECTED] = "ni",
+        [TOKEN_PONG] = "n",
+};
+
+char *g_host = "127.0.0.1";
+int g_port = 10000;
+int g_connections = 100;
+int g_threads = 4;
+int g_duration = 10; // Seconds.
+double g_rate = 0; // Rounds per second of all games, 0 = as fast as the games go.
+int g_mix = 0; // Percentage of choices followed by a get_games of the client.
+int g_goal = 3;
+int g_is_binary = 0;
+int g_is_running = 1;
+loadgen_pair_t *g_pairs = NULL;
+pthread_barrier_t g_barrier; // The test starts once all clients are connected.
+
+/// Microseconds between the times.
+/// \param from     The earlier time.
+/// \param to       The later time.
+/// \return         The microseconds.
+long _loadgen_elapsed(struct timespec *from, struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1000000L + (to->tv_nsec - from->tv_nsec) / 1000;
+}
+
+/// Bucket of the value. Buckets are linear within each power of 2, as the ones of the server statistics.
+/// \param value    The value.
+/// \return         Index of the bucket.
+int _loadgen_bucket(long value) {
+    int magnitude;
+    int index;
+
+    if (value < (1L << LOADGEN_HISTOGRAM_SUB_BITS))
+        return value < 0 ? 0 : (int) value;
+
+    magnitude = 63 - __builtin_clzl((unsigned long) value) - LOADGEN_HISTOGRAM_SUB_BITS;
+    index = ((magnitude + 1) << LOADGEN_HISTOGRAM_SUB_BITS)
+            + (int) ((value >> magnitude) & ((1L << LOADGEN_HISTOGRAM_SUB_BITS) - 1));
+
+    return index < LOADGEN_HISTOGRAM_BUCKETS ? index : LOADGEN_HISTOGRAM_BUCKETS - 1;
+}
+
+/// The highest value which falls into the bucket.
+/// \param index    Index of the bucket.
+/// \return         The value.
+long _loadgen_bucket_limit(int index) {
+    int magnitude;
+    long mantissa;
+
+    if (index < (1 << LOADGEN_HISTOGRAM_SUB_BITS))
+        return index;
+
+    magnitude = (index >> LOADGEN_HISTOGRAM_SUB_BITS) - 1;
+    mantissa = (index & ((1 << LOADGEN_HISTOGRAM_SUB_BITS) - 1)) | (1 << LOADGEN_HISTOGRAM_SUB_BITS);
+
+    return ((mantissa + 1) << magnitude) - 1;
+}
+
+/// Value below which the fraction of recorded values falls.
+/// \param histogram The histogram.
+/// \param fraction The fraction (0 .. 1).
+/// \return         Upper limit of the bucket of the value.
+long _loadgen_percentile(loadgen_histogram_t *histogram, double fraction) {
+    long rank = (long) (fraction * (double) histogram->count + 0.5);
+    long seen = 0;
+    int i;
+
+    if (rank < 1)
+        rank = 1;
+
+    for (i = 0; i < LOADGEN_HISTOGRAM_BUCKETS; ++i) {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+            return _loadgen_bucket_limit(i) < histogram->max ? _loadgen_bucket_limit(i) : histogram->max;
+    }
+
+    return histogram->max;
+}
+
+/// Send all the data. Sockets are blocking for writes, the server never stops reading.
+/// \param client   The client.
+/// \param data     The data.
+/// \param length   Length of the data.
+/// \return         Status code. 0 = Success, 1 = Error.
+int _loadgen_write(loadgen_client_t *client, char *data, size_t length) {
+    ssize_t result;
+
+    while (length > 0) {
+        result = send(client->socket, data, length, MSG_NOSIGNAL);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return 1;
+
+        data += result;
+        length -= (size_t) result;
+    }
+
+    return 0;
+}
+
+/// Append the varint.
+/// \param data     Where the varint is written.
+/// \param value    The value.
+/// \return         Count of written bytes.
+size_t _loadgen_varint(unsigned char *data, unsigned long value) {
+    size_t length = 0;
+
+    do {
+        data[length] = (unsigned char) (value & 0x7F);
+        value >>= 7;
+        if (value)
+            data[length] |= 0x80;
+        length++;
+    } while (value);
+
+    return length;
+}
+
+/// Send the request of the client by the protocol it uses. The request is remembered as pending.
+/// \param client   The client.
+/// \param token    The command.
+/// \param count    Count of the fields.
+/// \param fields   The fields, their kinds are by the command.
+/// \return         Status code. 0 = Success, 1 = Error.
+int _loadgen_request(loadgen_client_t *client, token_t token, int count, unsigned long *fields) {
+    char output[LOADGEN_OUTPUT_SIZE];
+    unsigned char *body = (unsigned char *) output + 2;
+    const char *kinds = g_token_fields[token] ? g_token_fields[token] : "";
+    size_t length = 0;
+    int i;
+
+    if (g_is_binary) {
+        // The length fits into 2 bytes of the varint, the body is written right after them.
+        body[length++] = (unsigned char) token;
+        length += _loadgen_varint(body + length, client->id_value);
+        for (i = 0; i < count; ++i)
+            length += _loadgen_varint(body + length, fields[i]);
+
+        output[0] = (char) ((length & 0x7F) | 0x80);
+        output[1] = (char) (length >> 7);
+        length += 2;
+
+    } else {
+        length = (size_t) sprintf(output, "%s;%s;", client->id, g_token_names[token]);
+        for (i = 0; i < count; ++i)
+            length += (size_t) sprintf(output + length, kinds[i] == 'i' ? "%016lx;" : "%lu;", fields[i]);
+        output[length++] = '\n';
+    }
+
+    client->is_pending[token] = 1;
+    clock_gettime(CLOCK_MONOTONIC, &client->sent_at[token]);
+
+    return _loadgen_write(client, output, length);
+}
+
+/// Record the latency of the pending request which the message answers.
+/// \param thread   The thread.
+/// \param client   The client.
+/// \param token    The command of the request.
+/// \param now      Current time.
+void _loadgen_answered(loadgen_thread_t *thread, loadgen_client_t *client, token_t token, struct timespec *now) {
+    loadgen_histogram_t *histogram = &thread->latency[token];
+    long value;
+
+    if (!client->is_pending[token])
+        return;
+
+    client->is_pending[token] = 0;
+    value = _loadgen_elapsed(&client->sent_at[token], now);
+
+    histogram->count++;
+    histogram->buckets[_loadgen_bucket(value)]++;
+    if (value > histogram->max)
+        histogram->max = value;
+}
+
+/// Let the first client of the pair create a game, once both of them are out of games.
+/// \param pair     The pair.
+void _loadgen_create(loadgen_pair_t *pair) {
+    unsigned long goal = (unsigned long) g_goal;
+
+    if (!g_is_running || !pair->clients[0].id_value || pair->clients[0].is_in_game || pair->clients[1].is_in_game)
+        return;
+
+    pair->game_value = 0;
+    _loadgen_request(&pair->clients[0], TOKEN_CREATE_NEW_GAME, 1, &goal);
+}
+
+/// Let the second client of the pair join the game of the first one, once both of them are known.
+/// \param pair     The pair.
+void _loadgen_join(loadgen_pair_t *pair) {
+    loadgen_client_t *client = &pair->clients[1];
+
+    if (!g_is_running || !pair->game_value || !client->id_value || client->is_in_game || client->is_pending[TOKEN_JOIN_PLAYER_TO_GAME])
+        return;
+
+    _loadgen_request(client, TOKEN_JOIN_PLAYER_TO_GAME, 1, &pair->game_value);
+}
+
+/// Both clients of the pair choose. The choices are sent together, so the latency is the one of evaluating the round.
+/// \param thread   The thread.
+/// \param pair     The pair.
+void _loadgen_play(loadgen_thread_t *thread, loadgen_pair_t *pair) {
+    loadgen_client_t *client = NULL;
+    unsigned long fields[2];
+    int i;
+
+    pair->is_waiting = 0;
+    thread->rounds++;
+
+    for (i = 0; i < 2; ++i) {
+        client = &pair->clients[i];
+        client->is_on_turn = 0;
+
+        fields[0] = (unsigned long) (rand_r(&thread->seed) % 3 + 1);
+        fields[1] = pair->game_value;
+        _loadgen_request(client, TOKEN_GAME_CHOICE_SELECTED, 2, fields);
+    }
+
+    for (i = 0; i < 2; ++i) {
+        client = &pair->clients[i];
+        if (rand_r(&thread->seed) % 100 < g_mix && !client->is_pending[TOKEN_GET_GAMES])
+            _loadgen_request(client, TOKEN_GET_GAMES, 0, NULL);
+    }
+}
+
+/// Play rounds of pairs waiting for the rate, as long as the rate lets.
+/// \param thread   The thread.
+/// \param now      Current time.
+void _loadgen_pace(loadgen_thread_t *thread, struct timespec *now) {
+    double rate = g_rate / g_threads;
+    int i;
+
+    if (g_rate <= 0)
+        return;
+
+    // Tokens do not pile up for more than a tick, so the rate is kept even after a stall.
+    thread->tokens += rate * (double) _loadgen_elapsed(&thread->refilled_at, now) / 1000000.0;
+    if (thread->tokens > rate * LOADGEN_TICK / 1000.0 + 1)
+        thread->tokens = rate * LOADGEN_TICK / 1000.0 + 1;
+    thread->refilled_at = *now;
+
+    for (i = 0; i < thread->pair_count && thread->waiting_count > 0 && thread->tokens >= 1; ++i) {
+        if (!thread->pairs[i].is_waiting)
+            continue;
+
+        thread->tokens -= 1;
+        thread->waiting_count--;
+        _loadgen_play(thread, &thread->pairs[i]);
+    }
+}
+
+/// Handle the message the client received.
+/// \param thread   The thread.
+/// \param client   The client.
+/// \param line     The message.
+void _loadgen_message(loadgen_thread_t *thread, loadgen_client_t *client, char *line) {
+    loadgen_pair_t *pair = client->pair;
+    loadgen_client_t *partner = &pair->clients[1 - client->index];
+    struct timespec now;
+    char *command = NULL;
+    char *game_id = NULL;
+    unsigned long sequence;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // Messages are "id;command;args".
+    command = strchr(line, ';');
+    if (!command)
+        return;
+    *command++ = '\0';
+
+    // A player lost before may be given back to a connection of the same address.
+    if (strncmp(command, "_player_id", 10) == 0) {
+        _loadgen_answered(thread, client, TOKEN_PLAYER_NICKNAME, &now);
+
+        snprintf(client->id, sizeof(client->id), "%s", line);
+        client->id_value = strtoul(line, NULL, 16);
+
+        // Deltas of the lobby are cheaper than snapshots of all games on each change.
+        _loadgen_request(client, TOKEN_LOBBY_SUBSCRIBE, 0, NULL);
+        client->is_pending[TOKEN_LOBBY_SUBSCRIBE] = 0;
+
+        if (client->index == 0)
+            _loadgen_create(pair);
+        else
+            _loadgen_join(pair);
+
+    } else if (strncmp(command, "prepare_window_for_game;", 24) == 0) {
+        client->is_in_game = 1;
+
+        if (client->index == 0) {
+            _loadgen_answered(thread, client, TOKEN_CREATE_NEW_GAME, &now);
+            game_id = command + 24;
+            pair->game_value = strtoul(game_id, NULL, 16);
+            _loadgen_join(pair);
+        } else {
+            _loadgen_answered(thread, client, TOKEN_JOIN_PLAYER_TO_GAME, &now);
+        }
+
+    } else if (strcmp(command, "on_turn") == 0) {
+        client->is_on_turn = 1;
+
+        if (!partner->is_on_turn || !g_is_running)
+            return;
+
+        if (g_rate > 0 && thread->tokens < 1) {
+            pair->is_waiting = 1;
+            thread->waiting_count++;
+        } else {
+            if (g_rate > 0)
+                thread->tokens -= 1;
+            _loadgen_play(thread, pair);
+        }
+
+    } else if (strncmp(command, "update_players", 14) == 0) {
+        _loadgen_answered(thread, client, TOKEN_GAME_CHOICE_SELECTED, &now);
+
+    } else if (strncmp(command, "update_games", 12) == 0) {
+        _loadgen_answered(thread, client, TOKEN_GET_GAMES, &now);
+
+    } else if (strcmp(command, "leave_game") == 0) {
+        client->is_in_game = 0;
+        client->is_on_turn = 0;
+        client->is_pending[TOKEN_GAME_CHOICE_SELECTED] = 0;
+
+        if (pair->is_waiting) {
+            pair->is_waiting = 0;
+            thread->waiting_count--;
+        }
+
+        if (!partner->is_in_game) {
+            thread->games++;
+            _loadgen_create(pair);
+        }
+
+    } else if (strncmp(command, "ping;", 5) == 0) {
+        sequence = strtoul(command + 5, NULL, 10);
+        _loadgen_request(client, TOKEN_PONG, 1, &sequence);
+        client->is_pending[TOKEN_PONG] = 0;
+
+    } else if (strcmp(command, "cannot_join_game") == 0 || strcmp(command, "kick_player") == 0) {
+        client->is_pending[TOKEN_JOIN_PLAYER_TO_GAME] = 0;
+        thread->errors++;
+    }
+}
+
+/// Read what the client received and handle complete messages.
+/// \param thread   The thread.
+/// \param client   The client.
+/// \return         Status code. 0 = Success, 1 = The connection is closed.
+int _loadgen_read(loadgen_thread_t *thread, loadgen_client_t *client) {
+    ssize_t result;
+    char *line = NULL;
+    char *end = NULL;
+    size_t used;
+
+    for (;;) {
+        result = recv(client->socket, client->input + client->input_length,
+                      LOADGEN_INPUT_SIZE - 1 - client->input_length, MSG_DONTWAIT);
+
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0;
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return 1;
+
+        client->input_length += (size_t) result;
+        line = client->input;
+
+        while ((end = memchr(line, '\n', client->input_length - (size_t) (line - client->input)))) {
+            *end = '\0';
+            if (end > line && end[-1] == '\r')
+                end[-1] = '\0';
+
+            if (!client->is_skipping)
+                _loadgen_message(thread, client, line);
+            client->is_skipping = 0;
+
+            line = end + 1;
+        }
+
+        used = (size_t) (line - client->input);
+        memmove(client->input, line, client->input_length - used);
+        client->input_length -= used;
+
+        // A long lobby snapshot does not fit, only its beginning is needed to tell what it is.
+        if (client->input_length == LOADGEN_INPUT_SIZE - 1) {
+            client->input[client->input_length] = '\0';
+            if (!client->is_skipping)
+                _loadgen_message(thread, client, client->input);
+            client->is_skipping = 1;
+            client->input_length = 0;
+        }
+    }
+}
+
+/// Connect the client.
+/// \param thread   The thread.
+/// \param client   The client.
+/// \return         Status code. 0 = Success, 1 = Error.
+int _loadgen_connect(loadgen_thread_t *thread, loadgen_client_t *client) {
+    struct sockaddr_in address;
+    struct epoll_event event;
+    int flag = 1;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t) g_port);
+    if (inet_pton(AF_INET, g_host, &address.sin_addr) != 1)
+        return 1;
+
+    client->socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (client->socket < 0)
+        return 1;
+
+    setsockopt(client->socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    if (connect(client->socket, (struct sockaddr *) &address, sizeof(address)))
+        return 1;
+
+    event.events = EPOLLIN;
+    event.data.ptr = client;
+    return epoll_ctl(thread->epoll_fd, EPOLL_CTL_ADD, client->socket, &event) != 0;
+}
+
+/// Send the handshake of the client.
+/// \param client   The client.
+/// \param number   Number of the client, it makes its nickname.
+/// \return         Status code. 0 = Success, 1 = Error.
+int _loadgen_handshake(loadgen_client_t *client, int number) {
+    char output[LOADGEN_OUTPUT_SIZE];
+
+    sprintf(output, "1;_player_nickname;lg%d;%s\n", number, g_is_binary ? "binary;" : "");
+    client->is_pending[TOKEN_PLAYER_NICKNAME] = 1;
+    clock_gettime(CLOCK_MONOTONIC, &client->sent_at[TOKEN_PLAYER_NICKNAME]);
+
+    return _loadgen_write(client, output, strlen(output));
+}
+
+/// Wait for messages of the clients of the thread and handle them.
+/// \param thread   The thread.
+/// \return         Count of connections closed by the server.
+int _loadgen_poll(loadgen_thread_t *thread) {
+    loadgen_client_t *client = NULL;
+    struct epoll_event events[LOADGEN_MAX_EVENTS];
+    int closed = 0;
+    int i, n;
+
+    n = epoll_wait(thread->epoll_fd, events, LOADGEN_MAX_EVENTS, LOADGEN_TICK);
+
+    for (i = 0; i < n; ++i) {
+        client = (loadgen_client_t *) events[i].data.ptr;
+
+        if (_loadgen_read(thread, client)) {
+            epoll_ctl(thread->epoll_fd, EPOLL_CTL_DEL, client->socket, NULL);
+            client->is_closed = 1;
+            closed++;
+        }
+    }
+
+    return closed;
+}
+
+/// Run the pairs of the thread until the end of the test. Then the players are removed from the server.
+/// \param arg      The thread.
+void *_loadgen_serve(void *arg) {
+    loadgen_thread_t *thread = (loadgen_thread_t *) arg;
+    loadgen_client_t *client = NULL;
+    struct timespec start, now;
+    int open = 0;
+    int i, j;
+
+    for (i = 0; i < thread->pair_count; ++i) {
+        for (j = 0; j < 2; ++j) {
+            client = &thread->pairs[i].clients[j];
+            client->pair = &thread->pairs[i];
+            client->index = j;
+
+            if (_loadgen_connect(thread, client)) {
+                printf("\t> Connection to %s:%d: ERROR (%s)!\n", g_host, g_port, strerror(errno));
+                exit(1);
+            }
+        }
+    }
+
+    pthread_barrier_wait(&g_barrier);
+    clock_gettime(CLOCK_MONOTONIC, &thread->refilled_at);
+
+    for (i = 0; i < thread->pair_count; ++i) {
+        for (j = 0; j < 2; ++j) {
+            client = &thread->pairs[i].clients[j];
+
+            if (_loadgen_handshake(client, (int) (client->pair - g_pairs) * 2 + j))
+                thread->errors++;
+        }
+    }
+
+    while (__atomic_load_n(&g_is_running, __ATOMIC_ACQUIRE)) {
+        thread->errors += _loadgen_poll(thread);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        _loadgen_pace(thread, &now);
+    }
+
+    // Remove the players and wait until the server closes the connections.
+    // A connection closed with unread data is reset, and the server would lose the disconnect.
+    for (i = 0; i < thread->pair_count; ++i) {
+        for (j = 0; j < 2; ++j) {
+            client = &thread->pairs[i].clients[j];
+            if (client->is_closed)
+                continue;
+
+            if (client->id_value)
+                _loadgen_request(client, TOKEN_DISCONNECT_PLAYER, 0, NULL);
+            shutdown(client->socket, SHUT_WR);
+            open++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        open -= _loadgen_poll(thread);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while (open > 0 && _loadgen_elapsed(&start, &now) < LOADGEN_DRAIN_TIMEOUT);
+
+    for (i = 0; i < thread->pair_count; ++i)
+        for (j = 0; j < 2; ++j)
+            close(thread->pairs[i].clients[j].socket);
+
+    close(thread->epoll_fd);
+
+    return NULL;
+}
+
+/// Print the throughput and the latency of each command of all threads.
+/// \param threads  The threads.
+/// \param seconds  Duration of the test.
+void _loadgen_report(loadgen_thread_t *threads, double seconds) {
+    loadgen_histogram_t total;
+    long games = 0;
+    long rounds = 0;
+    long errors = 0;
+    int token;
+    int i, j;
+
+    for (i = 0; i < g_threads; ++i) {
+        games += threads[i].games;
+        rounds += threads[i].rounds;
+        errors += threads[i].errors;
+    }
+
+    printf("Connections: %d, threads: %d, protocol: %s, duration: %.1f s\n", g_connections, g_threads,
+           g_is_binary ? "binary" : "text", seconds);
+    printf("Games: %ld (%.1f/s), rounds: %ld (%.1f/s), errors: %ld\n", games, games / seconds, rounds, rounds / seconds, errors);
+    printf("%-28s %10s %10s %10s %10s %10s %10s\n", "Command", "Answers", "Per second", "p50 us", "p90 us", "p99 us", "Max us");
+
+    for (token = 0; token < TOKEN_COUNT; ++token) {
+        memset(&total, 0, sizeof(total));
+
+        for (i = 0; i < g_threads; ++i) {
+            total.count += threads[i].latency[token].count;
+            if (threads[i].latency[token].max > total.max)
+                total.max = threads[i].latency[token].max;
+            for (j = 0; j < LOADGEN_HISTOGRAM_BUCKETS; ++j)
+                total.buckets[j] += threads[i].latency[token].buckets[j];
+        }
+
+        if (total.count == 0)
+            continue;
+
+        printf("%-28s %10ld %10.1f %10ld %10ld %10ld %10ld\n", g_token_names[token], total.count, total.count / seconds,
+               _loadgen_percentile(&total, 0.5), _loadgen_percentile(&total, 0.9), _loadgen_percentile(&total, 0.99), total.max);
+    }
+}
+
+/// Print how to use the tool.
+/// \param name     Name of the program.
+void _loadgen_usage(char *name) {
+    printf("Usage: %s [-h host] [-p port] [-c connections] [-t threads] [-d seconds] [-r rounds per second] [-m get_games %%] [-g goal] [-b]\n", name);
+    printf("\t-b\tUse the binary protocol for requests.\n");
+}
+
+/// Simulate pairs of clients playing games against the server and report the throughput and the latency by command.
+/// \param argv     Count of arguments.
+/// \param args     The arguments.
+/// \return         Status code. 0 = Success, 1 = Error.
+int main(int argv, char *args[]) {
+    loadgen_thread_t *threads = NULL;
+    struct timespec start, end;
+    int pair_count;
+    int option;
+    int i;
+
+    while ((option = getopt(argv, args, "h:p:c:t:d:r:m:g:b")) != -1) {
+        switch (option) {
+            case 'h': g_host = optarg; break;
+            case 'p': g_port = atoi(optarg); break;
+            case 'c': g_connections = atoi(optarg); break;
+            case 't': g_threads = atoi(optarg); break;
+            case 'd': g_duration = atoi(optarg); break;
+            case 'r': g_rate = atof(optarg); break;
+            case 'm': g_mix = atoi(optarg); break;
+            case 'g': g_goal = atoi(optarg); break;
+            case 'b': g_is_binary = 1; break;
+            default:
+                _loadgen_usage(args[0]);
+                return 1;
+        }
+    }
+
+    // Clients play in pairs, each pair is served by a single thread.
+    pair_count = g_connections / 2;
+    if (pair_count < 1 || g_threads < 1 || g_duration < 1 || g_mix < 0 || g_mix > 100) {
+        _loadgen_usage(args[0]);
+        return 1;
+    }
+    if (g_threads > pair_count)
+        g_threads = pair_count;
+    g_connections = pair_count * 2;
+
+    threads = calloc((size_t) g_threads, sizeof(loadgen_thread_t));
+    g_pairs = calloc((size_t) pair_count, sizeof(loadgen_pair_t));
+    if (!threads || !g_pairs) {
+        printf("\t> Memory: ERROR!\n");
+        return 1;
+    }
+
+    pthread_barrier_init(&g_barrier, NULL, (unsigned int) g_threads + 1);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0; i < g_threads; ++i) {
+        threads[i].index = i;
+        threads[i].seed = (unsigned int) (start.tv_nsec + i);
+        threads[i].pairs = g_pairs + (long) pair_count * i / g_threads;
+        threads[i].pair_count = (int) ((long) pair_count * (i + 1) / g_threads - (long) pair_count * i / g_threads);
+        threads[i].epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+        if (threads[i].epoll_fd < 0 || pthread_create(&threads[i].thread, NULL, _loadgen_serve, &threads[i])) {
+            printf("\t> Thread: ERROR!\n");
+            return 1;
+        }
+    }
+
+    pthread_barrier_wait(&g_barrier);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    sleep((unsigned int) g_duration);
+    __atomic_store_n(&g_is_running, 0, __ATOMIC_RELEASE);
+
+    for (i = 0; i < g_threads; ++i)
+        pthread_join(threads[i].thread, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    _loadgen_report(threads, (double) _loadgen_elapsed(&start, &end) / 1000000.0);
+
+    pthread_barrier_destroy(&g_barrier);
+    free(g_pairs);
+    free(threads);
+
+    return 0;
+}
@@ -0,0 +1,405 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "constants.h"
+#include "structs.h"
+#include "lobby.h"
+#include "server.h"
+#include "memory.h"
+#include "message.h"
+#include "player.h"
+#include "buffer.h"
+
+// Serialized list of open games ("1;update_games;name;id;goal;...\n"). Entries are in the order of the open game list.
+message_t l_snapshot;
+// Incremented on each change of the lobby, each change has its delta message.
+long g_lobby_version = 0;
+// Version of the last change which touched the snapshot.
+long l_snapshot_version = 0;
+// Delta messages of last LOBBY_HISTORY_SIZE versions, indexed by version.
+char *l_history[LOBBY_HISTORY_SIZE];
+
+// Players in the lobby (not playing any game).
+player_t *l_subscriber_list = NULL;
+long g_lobby_subscriber_count = 0;
+pthread_mutex_t l_subscriber_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Keeps updates of each subscriber in the order of versions. Subscribers are sent to without the subscriber mutex.
+pthread_mutex_t l_publish_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define LOBBY_HEADER "1;update_games" // Token message.
+#define LOBBY_HEADER_LENGTH 14
+
+/// Initialize an empty lobby snapshot.
+void lobby_init() {
+    int i;
+
+    message_init(&l_snapshot, 1024);
+    message_append(&l_snapshot, LOBBY_HEADER, LOBBY_HEADER_LENGTH);
+    message_append_char(&l_snapshot, '\n');
+
+    g_lobby_version = 0;
+    l_snapshot_version = 0;
+
+    for (i = 0; i < LOBBY_HISTORY_SIZE; ++i)
+        l_history[i] = NULL;
+}
+
+/// Start a delta message of the next version. Call it with the game table lock.
+/// \param message  The message.
+/// \param token    Token of the delta.
+void _lobby_delta_begin(message_t *message, char *token) {
+    g_lobby_version++;
+
+    message_init(message, 64 + ID_LENGTH * 2);
+    message_append(message, "1;", 2); // Token message.
+    message_append(message, token, strlen(token));
+    message_append_char(message, ';');
+    message_append_int(message, g_lobby_version);
+}
+
+/// Store the finished delta message into the history. Call it with the game table lock.
+/// \param message  The message.
+void _lobby_delta_end(message_t *message) {
+    char **slot = &l_history[g_lobby_version % LOBBY_HISTORY_SIZE];
+
+    message_append_char(message, '\n');
+
+    memory_free(*slot, 0);
+    *slot = message_finish(message);
+}
+
+/// Append the entry of a newly opened game to the snapshot. Call it with the game table lock.
+/// \param game     The game.
+void lobby_game_opened(game_t *game) {
+    message_t delta;
+
+    // Entry goes in place of the trailing new line.
+    l_snapshot.length--;
+    game->lobby_offset = l_snapshot.length;
+
+    message_append_char(&l_snapshot, ';');
+    message_append(&l_snapshot, game->name, ID_LENGTH + 5);
+    message_append_char(&l_snapshot, ';');
+    message_append(&l_snapshot, game->id, ID_LENGTH);
+    message_append_char(&l_snapshot, ';');
+    message_append_int(&l_snapshot, game->goal);
+
+    game->lobby_length = l_snapshot.length - game->lobby_offset;
+    message_append_char(&l_snapshot, '\n');
+
+    // The entry is the same as in the snapshot, the player count is added.
+    _lobby_delta_begin(&delta, "game_added");
+    message_append(&delta, l_snapshot.data + game->lobby_offset, game->lobby_length);
+    message_append_char(&delta, ';');
+    message_append_int(&delta, game->player_count);
+    _lobby_delta_end(&delta);
+
+    l_snapshot_version = g_lobby_version;
+}
+
+/// Player count of an open game changed. Call it with the game table lock.
+/// \param game     The game.
+void lobby_game_changed(game_t *game) {
+    message_t delta;
+
+    _lobby_delta_begin(&delta, "game_changed");
+    message_append_char(&delta, ';');
+    message_append(&delta, game->id, ID_LENGTH);
+    message_append_char(&delta, ';');
+    message_append_int(&delta, game->player_count);
+    _lobby_delta_end(&delta);
+}
+
+/// Cut the entry of the game out of the snapshot. Call it with the game table lock, before the game is unlinked from the open game list.
+/// \param game     The game.
+void lobby_game_closed(game_t *game) {
+    game_t *ptr = NULL;
+    message_t delta;
+    size_t end = game->lobby_offset + game->lobby_length;
+
+    memmove(l_snapshot.data + game->lobby_offset, l_snapshot.data + end, l_snapshot.length - end);
+    l_snapshot.length -= game->lobby_length;
+
+    // Entries of the following games moved.
+    for (ptr = game->open_next; ptr; ptr = ptr->open_next)
+        ptr->lobby_offset -= game->lobby_length;
+
+    game->lobby_offset = 0;
+    game->lobby_length = 0;
+
+    _lobby_delta_begin(&delta, "game_removed");
+    message_append_char(&delta, ';');
+    message_append(&delta, game->id, ID_LENGTH);
+    _lobby_delta_end(&delta);
+
+    l_snapshot_version = g_lobby_version;
+}
+
+/// Copy of the current snapshot, ready to be sent.
+/// \param version  If not NULL, it is set to the version of the snapshot.
+/// \return         The buffer. Release it by buffer_release.
+buffer_t *lobby_snapshot(long *version) {
+    buffer_t *message = NULL;
+
+    pthread_rwlock_rdlock(&g_game_table_lock);
+    message = _lobby_snapshot_copy(version);
+    pthread_rwlock_unlock(&g_game_table_lock);
+
+    return message;
+}
+
+/// Copy of the current snapshot. Call it with the game table lock.
+/// \param version  If not NULL, it is set to the version of the lobby.
+/// \return         The buffer.
+buffer_t *_lobby_snapshot_copy(long *version) {
+    buffer_t *message = buffer_create(l_snapshot.data, l_snapshot.length);
+
+    if (version)
+        *version = g_lobby_version;
+
+    return message;
+}
+
+/// Send the full snapshot to the subscriber. Delta subscribers get the version of the snapshot as well.
+/// \param player           The player.
+/// \param snapshot         The snapshot.
+/// \param version          Version of the snapshot.
+/// \param is_delta_mode    1 = The player gets delta updates.
+void _lobby_send_snapshot(player_t *player, buffer_t *snapshot, long version, int is_delta_mode) {
+    char message[64];
+
+    player_send_buffer(player, snapshot, 0, 0);
+
+    if (is_delta_mode) {
+        sprintf(message, "1;lobby_version;%ld\n", version); // Token message.
+        player_send(player, message, 0);
+    }
+}
+
+/// Add the player to lobby subscribers. Players in the lobby get updates of open games.
+/// \param player   The player.
+void lobby_subscribe(player_t *player) {
+    if (!player)
+        return;
+
+    pthread_mutex_lock(&l_subscriber_mutex);
+
+    // The removed player is unsubscribed for good, its game may be letting it go just now.
+    if (!player->is_subscribed && !__atomic_load_n(&player->is_removed, __ATOMIC_ACQUIRE)) {
+        player->is_subscribed = 1;
+        player->lobby_version = LOBBY_VERSION_NONE;
+        player->lobby_prev = NULL;
+        player->lobby_next = l_subscriber_list;
+        if (l_subscriber_list)
+            l_subscriber_list->lobby_prev = player;
+        l_subscriber_list = player;
+        g_lobby_subscriber_count++;
+    }
+
+    pthread_mutex_unlock(&l_subscriber_mutex);
+}
+
+/// Remove the player from lobby subscribers.
+/// \param player   The player.
+void lobby_unsubscribe(player_t *player) {
+    if (!player)
+        return;
+
+    pthread_mutex_lock(&l_subscriber_mutex);
+
+    if (player->is_subscribed) {
+        if (player->lobby_prev)
+            player->lobby_prev->lobby_next = player->lobby_next;
+        else
+            l_subscriber_list = player->lobby_next;
+        if (player->lobby_next)
+            player->lobby_next->lobby_prev = player->lobby_prev;
+
+        player->is_subscribed = 0;
+        player->lobby_next = NULL;
+        player->lobby_prev = NULL;
+        g_lobby_subscriber_count--;
+    }
+
+    pthread_mutex_unlock(&l_subscriber_mutex);
+}
+
+/// Switch the subscriber to delta updates and bring it up to date.
+/// \param player   The player.
+/// \param version  The last version the client knows, LOBBY_VERSION_NONE to get the snapshot.
+void lobby_subscribe_delta(player_t *player, long version) {
+    if (!player)
+        return;
+
+    pthread_mutex_lock(&l_subscriber_mutex);
+
+    player->lobby_mode = LOBBY_MODE_DELTA;
+    player->lobby_version = version >= 0 && version <= g_lobby_version ? version : LOBBY_VERSION_NONE;
+
+    pthread_mutex_unlock(&l_subscriber_mutex);
+
+    _lobby_publish(player);
+}
+
+/// Send the full snapshot to the player, whether it is changed or not.
+/// \param player   The player.
+void lobby_sync(player_t *player) {
+    if (!player)
+        return;
+
+    long version;
+    int is_delta_mode;
+    buffer_t *snapshot = NULL;
+
+    pthread_mutex_lock(&l_publish_mutex);
+
+    snapshot = lobby_snapshot(&version);
+
+    pthread_mutex_lock(&l_subscriber_mutex);
+    player->lobby_version = version;
+    is_delta_mode = player->lobby_mode == LOBBY_MODE_DELTA;
+    pthread_mutex_unlock(&l_subscriber_mutex);
+
+    _lobby_send_snapshot(player, snapshot, version, is_delta_mode);
+
+    pthread_mutex_unlock(&l_publish_mutex);
+
+    buffer_release(snapshot);
+}
+
+/// Bring all lobby subscribers up to date.
+void lobby_publish() {
+    _lobby_publish(NULL);
+}
+
+/// Bring lobby subscribers up to date. Legacy subscribers get the snapshot when it changes.
+/// Delta subscribers get all deltas since their version, or the snapshot if the deltas are not in the history anymore.
+/// Subscribers are only held and their updates decided under the subscriber mutex, they are sent to once it is unlocked.
+/// \param target   The only subscriber to be updated, or NULL for all of them.
+void _lobby_publish(player_t *target) {
+    player_t *player = NULL;
+    lobby_send_t *sends = NULL;
+    lobby_send_t *send = NULL;
+    int count = 0;
+    int i;
+    buffer_t *snapshot = NULL;
+    buffer_t *deltas = NULL;
+    long offsets[LOBBY_HISTORY_SIZE];
+    long oldest = -1;
+    long first;
+    long version;
+    long snapshot_version;
+    long v;
+    int needs_snapshot = 0;
+    message_t message;
+
+    pthread_mutex_lock(&l_publish_mutex);
+    pthread_mutex_lock(&l_subscriber_mutex);
+
+    if (target && !target->is_subscribed) {
+        pthread_mutex_unlock(&l_subscriber_mutex);
+        pthread_mutex_unlock(&l_publish_mutex);
+        return;
+    }
+
+    pthread_rwlock_rdlock(&g_game_table_lock);
+
+    version = g_lobby_version;
+    snapshot_version = l_snapshot_version;
+
+    // The oldest version whose delta is still in the history.
+    first = version - LOBBY_HISTORY_SIZE + 1 > 1 ? version - LOBBY_HISTORY_SIZE + 1 : 1;
+
+    // Find out what the subscribers need.
+    for (player = target ? target : l_subscriber_list; player; player = target ? NULL : player->lobby_next) {
+        if (player->is_disconnected == 1 || player->lobby_version == version)
+            continue;
+
+        if (player->lobby_version == LOBBY_VERSION_NONE)
+            needs_snapshot = 1;
+        else if (player->lobby_mode != LOBBY_MODE_DELTA)
+            needs_snapshot |= player->lobby_version < snapshot_version;
+        else if (player->lobby_version + 1 < first)
+            needs_snapshot = 1; // Version gap, the deltas are gone.
+        else if (oldest < 0 || player->lobby_version < oldest)
+            oldest = player->lobby_version;
+    }
+
+    if (needs_snapshot)
+        snapshot = _lobby_snapshot_copy(NULL);
+
+    // Concatenate all needed deltas, so each subscriber gets a suffix of the same buffer.
+    if (oldest >= 0) {
+        first = oldest + 1;
+        message_init_buffer(&message, 64 * (version - first + 1));
+
+        for (v = first; v <= version; ++v) {
+            offsets[v - first] = (long) message.length;
+            message_append(&message, l_history[v % LOBBY_HISTORY_SIZE], strlen(l_history[v % LOBBY_HISTORY_SIZE]));
+        }
+
+        deltas = message_finish_buffer(&message);
+    }
+
+    pthread_rwlock_unlock(&g_game_table_lock);
+
+    if (target || g_lobby_subscriber_count)
+        sends = memory_malloc(sizeof(lobby_send_t) * (target ? 1 : g_lobby_subscriber_count), 0);
+
+    for (player = target ? target : l_subscriber_list; player; player = target ? NULL : player->lobby_next) {
+        if (player->is_disconnected == 1 || player->lobby_version == version)
+            continue;
+
+        if (player->lobby_mode != LOBBY_MODE_DELTA && player->lobby_version != LOBBY_VERSION_NONE && player->lobby_version >= snapshot_version) {
+            player->lobby_version = version; // Nothing the client would see has changed.
+            continue;
+        }
+
+        send = &sends[count++];
+        send->player = player;
+        send->is_delta_mode = player->lobby_mode == LOBBY_MODE_DELTA;
+        send->is_snapshot = player->lobby_version == LOBBY_VERSION_NONE || !send->is_delta_mode
+                            || oldest < 0 || player->lobby_version < oldest;
+        send->offset = send->is_snapshot ? 0 : (size_t) offsets[player->lobby_version + 1 - first];
+
+        player_hold(player);
+        player->lobby_version = version;
+    }
+
+    pthread_mutex_unlock(&l_subscriber_mutex);
+
+    for (i = 0; i < count; ++i) {
+        if (sends[i].is_snapshot)
+            _lobby_send_snapshot(sends[i].player, snapshot, version, sends[i].is_delta_mode);
+        else
+            player_send_buffer(sends[i].player, deltas, sends[i].offset, 1);
+
+        player_release(sends[i].player);
+    }
+
+    pthread_mutex_unlock(&l_publish_mutex);
+
+    memory_free(sends, 0);
+    buffer_release(snapshot);
+    buffer_release(deltas);
+}
+
+/// Free the snapshot and the history.
+void lobby_free() {
+    int i;
+
+    for (i = 0; i < LOBBY_HISTORY_SIZE; ++i) {
+        memory_free(l_history[i], 0);
+        l_history[i] = NULL;
+    }
+
+    memory_free(l_snapshot.data, 0);
+    l_snapshot.data = NULL;
+    l_snapshot.length = 0;
+    l_snapshot.capacity = 0;
+}
@@ -0,0 +1,28 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_LOBBY_H
+#define SERVER_LOBBY_H
+
+extern long g_lobby_version;
+extern long g_lobby_subscriber_count;
+
+void lobby_init();
+void _lobby_delta_begin(message_t *message, char *token);
+void _lobby_delta_end(message_t *message);
+void lobby_game_opened(game_t *game);
+void lobby_game_changed(game_t *game);
+void lobby_game_closed(game_t *game);
+buffer_t *lobby_snapshot(long *version);
+buffer_t *_lobby_snapshot_copy(long *version);
+void _lobby_send_snapshot(player_t *player, buffer_t *snapshot, long version, int is_delta_mode);
+void lobby_subscribe(player_t *player);
+void lobby_unsubscribe(player_t *player);
+void lobby_subscribe_delta(player_t *player, long version);
+void lobby_sync(player_t *player);
+void lobby_publish();
+void _lobby_publish(player_t *target);
+void lobby_free();
+
+#endif //SERVER_LOBBY_H
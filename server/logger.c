@@ -0,0 +1,217 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "constants.h"
+#include "structs.h"
+#include "logger.h"
+
+long g_logger_dropped = 0;
+
+// Bounded ring of log entries. Producers claim slots by the tail, the writer thread consumes them by the head.
+log_entry_t w_ring[LOGGER_RING_SIZE];
+unsigned long w_tail = 0;
+unsigned long w_head = 0;
+
+int w_file = -1;
+int w_is_running = 0;
+int w_is_sleeping = 0;
+sem_t w_wakeup;
+pthread_mutex_t w_flush_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_t w_thread;
+
+/// Open the log file and start the writer thread.
+void logger_init() {
+    int i;
+
+    for (i = 0; i < LOGGER_RING_SIZE; ++i)
+        w_ring[i].sequence = (unsigned long) i;
+
+    w_file = open(LOGGER_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (w_file < 0)
+        printf("\t> Log file: ERROR!\n");
+
+    sem_init(&w_wakeup, 0, 0);
+    w_is_running = 1;
+
+    if (pthread_create(&w_thread, NULL, _logger_serve, NULL)) {
+        printf("\t> Logger thread: ERROR!\n");
+        w_is_running = 0;
+    }
+}
+
+/// Queue the log message for the writer thread. The message is stamped with the current time.
+/// If the logger does not run, the message is written right away.
+/// \param log      The message.
+/// \return         Status code. 0 = Success, 1 = Dropped.
+int logger_write(char *log) {
+    log_entry_t *entry = NULL;
+    log_entry_t local;
+    unsigned long position;
+    long difference;
+    size_t length = strlen(log);
+
+    if (length > LOGGER_ENTRY_SIZE)
+        length = LOGGER_ENTRY_SIZE;
+
+    if (!__atomic_load_n(&w_is_running, __ATOMIC_ACQUIRE)) {
+        clock_gettime(CLOCK_REALTIME, &local.time);
+        local.length = (unsigned int) length;
+        memcpy(local.text, log, length);
+        _logger_flush(&local, 1);
+        return 0;
+    }
+
+    position = __atomic_load_n(&w_tail, __ATOMIC_RELAXED);
+
+    for (;;) {
+        entry = &w_ring[position & (LOGGER_RING_SIZE - 1)];
+        difference = (long) (__atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE) - position);
+
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&w_tail, &position, position + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+
+        } else if (difference < 0) {
+            // The ring is full.
+            if (LOGGER_POLICY == LOGGER_POLICY_DROP) {
+                __atomic_fetch_add(&g_logger_dropped, 1, __ATOMIC_RELAXED);
+                return 1;
+            }
+
+            _logger_wake();
+            sched_yield();
+            position = __atomic_load_n(&w_tail, __ATOMIC_RELAXED);
+
+        } else {
+            position = __atomic_load_n(&w_tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    clock_gettime(CLOCK_REALTIME, &entry->time);
+    entry->length = (unsigned int) length;
+    memcpy(entry->text, log, length);
+
+    __atomic_store_n(&entry->sequence, position + 1, __ATOMIC_RELEASE);
+
+    _logger_wake();
+
+    return 0;
+}
+
+/// Wake the writer thread up if it waits for messages.
+void _logger_wake() {
+    if (__atomic_exchange_n(&w_is_sleeping, 0, __ATOMIC_SEQ_CST))
+        sem_post(&w_wakeup);
+}
+
+/// Format the entries and write them into the log file and the console, each with a single call.
+/// \param entries  The entries.
+/// \param count    Count of the entries.
+void _logger_flush(log_entry_t *entries, int count) {
+    static char file_batch[LOGGER_BATCH_SIZE];
+    static char console_batch[LOGGER_BATCH_SIZE];
+    size_t file_length = 0;
+    size_t console_length = 0;
+    struct tm time_local;
+    int i;
+
+    // The writer thread is the only one flushing while the logger runs.
+    pthread_mutex_lock(&w_flush_mutex);
+
+    for (i = 0; i < count; ++i) {
+        localtime_r(&entries[i].time.tv_sec, &time_local);
+        file_length += strftime(file_batch + file_length, LOGGER_BATCH_SIZE - file_length, "%a %b %d %H:%M:%S", &time_local);
+        file_length += (size_t) sprintf(file_batch + file_length, ".%03ld\t", entries[i].time.tv_nsec / 1000000);
+        memcpy(file_batch + file_length, entries[i].text, entries[i].length);
+        file_length += entries[i].length;
+
+        // Keep each entry on its own line.
+        if (entries[i].length == 0 || entries[i].text[entries[i].length - 1] != '\n')
+            file_batch[file_length++] = '\n';
+
+        memcpy(console_batch + console_length, entries[i].text, entries[i].length);
+        console_length += entries[i].length;
+    }
+
+    if (w_file >= 0 && file_length > 0 && write(w_file, file_batch, file_length) < 0)
+        printf("\t> Log file: ERROR during writing!\n");
+    if (console_length > 0 && write(STDOUT_FILENO, console_batch, console_length) < 0)
+        console_length = 0;
+
+    pthread_mutex_unlock(&w_flush_mutex);
+}
+
+/// Drain the ring in batches until the logger is stopped and the ring is empty.
+/// \param arg      Unused.
+void *_logger_serve(void *arg) {
+    // A batch fits the buffers even with the timestamp and the line ending added to each entry.
+    static log_entry_t batch[LOGGER_BATCH_SIZE / (LOGGER_ENTRY_SIZE + 32)];
+    log_entry_t *entry = NULL;
+    int count;
+    int is_running;
+
+    for (;;) {
+        count = 0;
+        is_running = __atomic_load_n(&w_is_running, __ATOMIC_ACQUIRE);
+
+        while (count < (int) (sizeof(batch) / sizeof(batch[0]))) {
+            entry = &w_ring[w_head & (LOGGER_RING_SIZE - 1)];
+            if (__atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE) != w_head + 1)
+                break;
+
+            batch[count].time = entry->time;
+            batch[count].length = entry->length;
+            memcpy(batch[count].text, entry->text, entry->length);
+            count++;
+
+            // Hand the slot back to producers.
+            __atomic_store_n(&entry->sequence, w_head + LOGGER_RING_SIZE, __ATOMIC_RELEASE);
+            w_head++;
+        }
+
+        if (count > 0) {
+            _logger_flush(batch, count);
+            continue;
+        }
+
+        if (!is_running)
+            break;
+
+        // Announce the sleep first, then check again, so a message queued meanwhile is not missed.
+        __atomic_store_n(&w_is_sleeping, 1, __ATOMIC_SEQ_CST);
+        entry = &w_ring[w_head & (LOGGER_RING_SIZE - 1)];
+        if (__atomic_load_n(&entry->sequence, __ATOMIC_SEQ_CST) == w_head + 1
+            || !__atomic_load_n(&w_is_running, __ATOMIC_SEQ_CST)) {
+            if (__atomic_exchange_n(&w_is_sleeping, 0, __ATOMIC_SEQ_CST))
+                continue;
+        }
+
+        sem_wait(&w_wakeup);
+    }
+
+    return NULL;
+}
+
+/// Stop the writer thread after it writes all queued messages, and close the log file.
+void logger_free() {
+    if (__atomic_exchange_n(&w_is_running, 0, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&w_is_sleeping, 0, __ATOMIC_SEQ_CST);
+        sem_post(&w_wakeup);
+        pthread_join(w_thread, NULL);
+    }
+
+    sem_destroy(&w_wakeup);
+
+    if (w_file >= 0)
+        close(w_file);
+    w_file = -1;
+}
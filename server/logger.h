@@ -0,0 +1,17 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_LOGGER_H
+#define SERVER_LOGGER_H
+
+extern long g_logger_dropped;
+
+void logger_init();
+int logger_write(char *log);
+void _logger_wake();
+void _logger_flush(log_entry_t *entries, int count);
+void *_logger_serve(void *arg);
+void logger_free();
+
+#endif //SERVER_LOGGER_H
@@ -4,51 +4,348 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <pthread.h>
+#include "constants.h"
+#include "structs.h"
 #include "memory.h"
 
+// Size of the block header. Keeps the returned memory 16 bytes aligned.
+#define MEMORY_HEADER_SIZE 16
+// Size class of allocations which are served directly by malloc.
+#define MEMORY_CLASS_LARGE MEMORY_CLASS_COUNT
+
 // Global variables.
-long m_current_allocation_count = 0;
+// Blocks shared between threads, one free list for each size class.
+memory_block_t *m_depot[MEMORY_CLASS_COUNT];
+long m_depot_count[MEMORY_CLASS_COUNT];
+pthread_mutex_t m_depot_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Caches of all running threads and counters of finished threads.
+memory_cache_t *m_cache_list = NULL;
+memory_cache_t m_retired;
+pthread_mutex_t m_cache_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_key_t m_cache_key;
+pthread_once_t m_cache_key_once = PTHREAD_ONCE_INIT;
+
+// Bytes reserved for slabs.
+long m_slab_bytes = 0;
+
+// Cache of the current thread.
+static __thread memory_cache_t *m_cache = NULL;
+
+/// Size of blocks of the size class.
+/// \param c        The size class.
+/// \return         Size in bytes (without the header).
+size_t _memory_class_size(int c) {
+    return (size_t) MEMORY_CLASS_SMALLEST << c;
+}
+
+/// Size class which fits the size.
+/// \param size     The size.
+/// \return         The size class or MEMORY_CLASS_LARGE.
+int _memory_class(size_t size) {
+    int c = 0;
+
+    while (c < MEMORY_CLASS_COUNT && _memory_class_size(c) < size)
+        c++;
+
+    return c;
+}
+
+/// Allocate memory from the system.
+/// \param size     Allocate memory of that size.
+/// \return         Pointer to the location the memory or NULL, if the system is out of memory.
+void *_memory_system_malloc(size_t size) {
+    return malloc(size);
+}
+
+/// The system is out of memory. Waiting for it would stall all connections of the thread, so the server stops right away.
+/// Callers of memory_malloc do not have to check the result.
+/// \param size     Size which could not be allocated.
+void _memory_exhausted(size_t size) {
+    fprintf(stderr, "\t> Fatal ERROR, out of memory (%lu B)!\n", (unsigned long) size);
+    abort();
+}
+
+/// Create the thread key which flushes the cache at the thread exit.
+void _memory_cache_key_create() {
+    pthread_key_create(&m_cache_key, _memory_cache_destroy);
+}
+
+/// Get the cache of the current thread, create it on the first use.
+/// \return         The cache or NULL, if the system is out of memory.
+memory_cache_t *_memory_cache() {
+    if (m_cache)
+        return m_cache;
+
+    pthread_once(&m_cache_key_once, _memory_cache_key_create);
+
+    m_cache = _memory_system_malloc(sizeof(memory_cache_t));
+    if (!m_cache)
+        return NULL;
+    memset(m_cache, 0, sizeof(memory_cache_t));
+
+    pthread_mutex_lock(&m_cache_list_mutex);
+    m_cache->next = m_cache_list;
+    m_cache_list = m_cache;
+    pthread_mutex_unlock(&m_cache_list_mutex);
+
+    pthread_setspecific(m_cache_key, m_cache);
+
+    return m_cache;
+}
+
+/// Give all cached blocks back to the depot and keep counters of the finished thread.
+/// \param arg      The cache.
+void _memory_cache_destroy(void *arg) {
+    memory_cache_t *cache = (memory_cache_t *) arg;
+    memory_cache_t **ptr = NULL;
+    int c;
+
+    for (c = 0; c < MEMORY_CLASS_COUNT; ++c)
+        _memory_cache_flush(cache, c, cache->count[c]);
+
+    pthread_mutex_lock(&m_cache_list_mutex);
+
+    for (ptr = &m_cache_list; *ptr; ptr = &(*ptr)->next) {
+        if (*ptr == cache) {
+            *ptr = cache->next;
+            break;
+        }
+    }
+
+    for (c = 0; c <= MEMORY_CLASS_COUNT; ++c) {
+        m_retired.allocations[c] += cache->allocations[c];
+        m_retired.frees[c] += cache->frees[c];
+    }
+
+    pthread_mutex_unlock(&m_cache_list_mutex);
+
+    if (cache == m_cache)
+        m_cache = NULL;
+
+    free(cache);
+}
+
+/// Move blocks of the size class from the thread cache to the depot.
+/// \param cache    The cache.
+/// \param c        The size class.
+/// \param count    Number of blocks.
+void _memory_cache_flush(memory_cache_t *cache, int c, long count) {
+    memory_block_t *first = cache->free[c];
+    memory_block_t *last = NULL;
+    long i;
+
+    if (count <= 0)
+        return;
+
+    // Detach first count blocks.
+    last = first;
+    for (i = 1; i < count; ++i)
+        last = last->next;
+
+    cache->free[c] = last->next;
+    cache->count[c] -= count;
+
+    pthread_mutex_lock(&m_depot_mutex);
+    last->next = m_depot[c];
+    m_depot[c] = first;
+    m_depot_count[c] += count;
+    pthread_mutex_unlock(&m_depot_mutex);
+}
 
- /// Custom malloc function for better debug memory allocation.
- /// \param size     Allocate memory of that size.
- /// \param c        Constant for debugging. Default = 0;
- /// \return         Pointer to the location the memory.
+/// Fill the thread cache with blocks of the size class. Takes them from the depot or carves a new slab.
+/// \param cache    The cache.
+/// \param c        The size class.
+/// \return         Status code. 0 = Success, 1 = The system is out of memory.
+int _memory_cache_refill(memory_cache_t *cache, int c) {
+    memory_block_t *block = NULL;
+    size_t block_size = MEMORY_HEADER_SIZE + _memory_class_size(c);
+    long count = 0;
+    long i;
+    char *slab = NULL;
+
+    pthread_mutex_lock(&m_depot_mutex);
+
+    while (m_depot[c] && count < MEMORY_CACHE_BATCH) {
+        block = m_depot[c];
+        m_depot[c] = block->next;
+        m_depot_count[c]--;
+
+        block->next = cache->free[c];
+        cache->free[c] = block;
+        count++;
+    }
+
+    pthread_mutex_unlock(&m_depot_mutex);
+
+    if (count)
+        cache->count[c] += count;
+    else {
+        // Depot is empty, carve a new slab. Slabs are never returned to the system.
+        count = MEMORY_SLAB_SIZE / block_size;
+        if (count < 1)
+            count = 1;
+
+        slab = _memory_system_malloc(block_size * count);
+        if (!slab)
+            return 1;
+        __atomic_add_fetch(&m_slab_bytes, (long) (block_size * count), __ATOMIC_RELAXED);
+
+        for (i = 0; i < count; ++i) {
+            block = (memory_block_t *) (slab + i * block_size);
+            block->next = cache->free[c];
+            cache->free[c] = block;
+        }
+
+        cache->count[c] += count;
+
+        // Keep only one batch in the thread, share the rest.
+        if (cache->count[c] > MEMORY_CACHE_BATCH)
+            _memory_cache_flush(cache, c, cache->count[c] - MEMORY_CACHE_BATCH);
+    }
+
+    return 0;
+}
+
+/// Custom malloc function. Small sizes are served from slabs cached by the calling thread.
+/// \param size     Allocate memory of that size.
+/// \param c        Constant for debugging. Default = 0;
+/// \return         Pointer to the location the memory.
 void *memory_malloc(size_t size, int c) {
     if (!size)
         return NULL;
 
-    void *m = NULL;
+    memory_cache_t *cache = _memory_cache();
+    memory_block_t *block = NULL;
+    int size_class = _memory_class(size);
+    char *m = NULL;
+
+    if (!cache)
+        _memory_exhausted(sizeof(memory_cache_t));
+
+    if (size_class == MEMORY_CLASS_LARGE) {
+        m = _memory_system_malloc(MEMORY_HEADER_SIZE + size);
+        if (!m)
+            _memory_exhausted(MEMORY_HEADER_SIZE + size);
+    } else {
+        if (!cache->free[size_class] && _memory_cache_refill(cache, size_class))
+            _memory_exhausted(MEMORY_SLAB_SIZE);
 
-    m = malloc(size);
-    while (m == NULL) {
-        sleep(1);
-        m = malloc(size);
+        block = cache->free[size_class];
+        cache->free[size_class] = block->next;
+        cache->count[size_class]--;
+        m = (char *) block;
     }
 
-    m_current_allocation_count++;
+    // Remember the size class for the free function.
+    *(int *) m = size_class;
+
+    // Only this thread writes its counters, readers just sum them up.
+    __atomic_store_n(&cache->allocations[size_class], cache->allocations[size_class] + 1, __ATOMIC_RELAXED);
 
     if (c > 0)
         printf("::: %d\n", c);
 
-    return m;
+    return m + MEMORY_HEADER_SIZE;
 }
 
- /// Custom free function for better debug memory allocation.
- /// \param ptr      Free the pointer memory.
- /// \param c        Constant for debugging. Default = 0;
+/// Custom free function. Small blocks are kept in the cache of the calling thread.
+/// \param ptr      Free the pointer memory.
+/// \param c        Constant for debugging. Default = 0;
 void memory_free(void *ptr, int c) {
     if (!ptr)
         return;
 
-    m_current_allocation_count--;
-    free(ptr);
+    memory_cache_t *cache = _memory_cache();
+    memory_block_t *block = (memory_block_t *) ((char *) ptr - MEMORY_HEADER_SIZE);
+    int size_class = *(int *) block;
+
+    // Without the cache the block goes straight back, so freeing never needs memory.
+    if (!cache) {
+        pthread_mutex_lock(&m_cache_list_mutex);
+        m_retired.frees[size_class]++;
+        pthread_mutex_unlock(&m_cache_list_mutex);
+
+        if (size_class == MEMORY_CLASS_LARGE) {
+            free(block);
+        } else {
+            pthread_mutex_lock(&m_depot_mutex);
+            block->next = m_depot[size_class];
+            m_depot[size_class] = block;
+            m_depot_count[size_class]++;
+            pthread_mutex_unlock(&m_depot_mutex);
+        }
+
+        return;
+    }
+
+    __atomic_store_n(&cache->frees[size_class], cache->frees[size_class] + 1, __ATOMIC_RELAXED);
+
+    if (size_class == MEMORY_CLASS_LARGE) {
+        free(block);
+    } else {
+        block->next = cache->free[size_class];
+        cache->free[size_class] = block;
+        cache->count[size_class]++;
+
+        if (cache->count[size_class] > 2 * MEMORY_CACHE_BATCH)
+            _memory_cache_flush(cache, size_class, MEMORY_CACHE_BATCH);
+    }
 
     if (c > 0)
         printf("::: %d\n", c);
 }
 
+/// Sum up allocation counters of all threads.
+/// \param allocations  Number of allocations for each size class (MEMORY_CLASS_COUNT + 1 items).
+/// \param frees        Number of frees for each size class (MEMORY_CLASS_COUNT + 1 items).
+void _memory_sum(long *allocations, long *frees) {
+    memory_cache_t *cache = NULL;
+    int c;
+
+    pthread_mutex_lock(&m_cache_list_mutex);
+
+    for (c = 0; c <= MEMORY_CLASS_COUNT; ++c) {
+        allocations[c] = m_retired.allocations[c];
+        frees[c] = m_retired.frees[c];
+    }
+
+    for (cache = m_cache_list; cache; cache = cache->next) {
+        for (c = 0; c <= MEMORY_CLASS_COUNT; ++c) {
+            allocations[c] += __atomic_load_n(&cache->allocations[c], __ATOMIC_RELAXED);
+            frees[c] += __atomic_load_n(&cache->frees[c], __ATOMIC_RELAXED);
+        }
+    }
+
+    pthread_mutex_unlock(&m_cache_list_mutex);
+}
+
+/// Bytes reserved for slabs.
+/// \return         The bytes.
+long memory_slab_bytes() {
+    return __atomic_load_n(&m_slab_bytes, __ATOMIC_RELAXED);
+}
+
 /// Print status of the memory.
 void memory_print_status() {
-    printf("==============================\nMemory allocation: %li times.\n==============================\n", m_current_allocation_count);
-}
\ No newline at end of file
+    long allocations[MEMORY_CLASS_COUNT + 1];
+    long frees[MEMORY_CLASS_COUNT + 1];
+    long total = 0;
+    int c;
+
+    _memory_sum(allocations, frees);
+
+    for (c = 0; c <= MEMORY_CLASS_COUNT; ++c)
+        total += allocations[c] - frees[c];
+
+    printf("==============================\nMemory allocation: %li times.\n", total);
+
+    for (c = 0; c < MEMORY_CLASS_COUNT; ++c)
+        printf("Class %6lu B: %li in use.\n", _memory_class_size(c), allocations[c] - frees[c]);
+    printf("Class  large: %li in use.\n", allocations[MEMORY_CLASS_LARGE] - frees[MEMORY_CLASS_LARGE]);
+
+    printf("Slabs: %li B.\n==============================\n", __atomic_load_n(&m_slab_bytes, __ATOMIC_RELAXED));
+}
@@ -17,4 +17,16 @@ void memory_free(void *ptr, int c);
 /// Print status of the memory.
 void memory_print_status();
 
+size_t _memory_class_size(int c);
+int _memory_class(size_t size);
+void *_memory_system_malloc(size_t size);
+void _memory_exhausted(size_t size);
+void _memory_cache_key_create();
+memory_cache_t *_memory_cache();
+void _memory_cache_destroy(void *arg);
+void _memory_cache_flush(memory_cache_t *cache, int c, long count);
+int _memory_cache_refill(memory_cache_t *cache, int c);
+void _memory_sum(long *allocations, long *frees);
+long memory_slab_bytes();
+
 #endif //SERVER_MEMORY_H
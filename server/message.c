@@ -0,0 +1,123 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "structs.h"
+#include "message.h"
+#include "memory.h"
+
+/// Start building a message.
+/// \param message      The message.
+/// \param capacity     Expected length of the message.
+void message_init(message_t *message, size_t capacity) {
+    message->capacity = capacity > 0 ? capacity : 1;
+    message->length = 0;
+    message->header = 0;
+    message->data = memory_malloc(sizeof(char) * message->capacity, 0);
+}
+
+/// Start building a message which is finished as a buffer. The data are built right in place of the buffer, so it is not copied.
+/// \param message      The message.
+/// \param capacity     Expected length of the message.
+void message_init_buffer(message_t *message, size_t capacity) {
+    message->capacity = capacity > 0 ? capacity : 1;
+    message->length = 0;
+    message->header = offsetof(buffer_t, data);
+    message->data = (char *) memory_malloc(message->header + sizeof(char) * message->capacity, 0) + message->header;
+}
+
+/// Make sure there is a space for another length chars and the terminating zero.
+/// \param message      The message.
+/// \param length       Number of chars to be appended.
+void _message_reserve(message_t *message, size_t length) {
+    size_t capacity = message->capacity;
+    char *data = NULL;
+
+    if (message->length + length + 1 <= capacity)
+        return;
+
+    while (message->length + length + 1 > capacity)
+        capacity *= 2;
+
+    data = (char *) memory_malloc(message->header + sizeof(char) * capacity, 0) + message->header;
+    memcpy(data, message->data, message->length);
+    memory_free(message->data - message->header, 0);
+
+    message->data = data;
+    message->capacity = capacity;
+}
+
+/// Append data of the known length.
+/// \param message      The message.
+/// \param data         The data.
+/// \param length       Length of the data.
+void message_append(message_t *message, const char *data, size_t length) {
+    _message_reserve(message, length);
+    memcpy(message->data + message->length, data, length);
+    message->length += length;
+}
+
+/// Append a single char.
+/// \param message      The message.
+/// \param c            The char.
+void message_append_char(message_t *message, char c) {
+    _message_reserve(message, 1);
+    message->data[message->length++] = c;
+}
+
+/// Append a decimal number.
+/// \param message      The message.
+/// \param value        The number.
+void message_append_int(message_t *message, long value) {
+    char digits[24];
+    int i = sizeof(digits);
+    unsigned long u = value < 0 ? -(unsigned long) value : (unsigned long) value;
+
+    do {
+        digits[--i] = (char) ('0' + u % 10);
+        u /= 10;
+    } while (u);
+
+    if (value < 0)
+        digits[--i] = '-';
+
+    message_append(message, digits + i, sizeof(digits) - i);
+}
+
+/// Terminate the message and hand over its data. Only for messages started by message_init. The data are freed by memory_free.
+/// \param message      The message.
+/// \return             Null-terminated message.
+char *message_finish(message_t *message) {
+    char *data = NULL;
+
+    _message_reserve(message, 0);
+    data = message->data;
+    data[message->length] = '\0';
+
+    message->data = NULL;
+    message->capacity = 0;
+
+    return data;
+}
+
+/// Terminate the message and turn it into a buffer. Only for messages started by message_init_buffer.
+/// \param message      The message.
+/// \return             The buffer with a single reference.
+buffer_t *message_finish_buffer(message_t *message) {
+    buffer_t *buffer = NULL;
+
+    _message_reserve(message, 0);
+    message->data[message->length] = '\0';
+
+    buffer = (buffer_t *) (message->data - message->header);
+    buffer->reference_count = 1;
+    buffer->length = message->length;
+
+    message->data = NULL;
+    message->capacity = 0;
+
+    return buffer;
+}
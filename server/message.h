@@ -0,0 +1,17 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_MESSAGE_H
+#define SERVER_MESSAGE_H
+
+void message_init(message_t *message, size_t capacity);
+void message_init_buffer(message_t *message, size_t capacity);
+void _message_reserve(message_t *message, size_t length);
+void message_append(message_t *message, const char *data, size_t length);
+void message_append_char(message_t *message, char c);
+void message_append_int(message_t *message, long value);
+char *message_finish(message_t *message);
+buffer_t *message_finish_buffer(message_t *message);
+
+#endif //SERVER_MESSAGE_H
@@ -0,0 +1,287 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "constants.h"
+#include "structs.h"
+#include "metrics.h"
+#include "stats.h"
+#include "logger.h"
+#include "memory.h"
+#include "message.h"
+#include "reactor.h"
+#include "server.h"
+
+#define METRICS_HEADER "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n"
+
+long g_metrics_gauges[METRICS_GAUGE_COUNT];
+
+int e_socket = -1;
+pthread_t e_thread;
+
+/// Change the gauge.
+/// \param gauge    The gauge.
+/// \param delta    The change.
+void metrics_gauge_add(metrics_gauge_t gauge, long delta) {
+    __atomic_fetch_add(&g_metrics_gauges[gauge], delta, __ATOMIC_RELAXED);
+}
+
+/// Start listening for scrapes on the local port. Each request is answered with the current snapshot.
+/// \param port     The port.
+/// \return         Status code. 0 = Success, 1 = Error.
+int metrics_init(int port) {
+    int flag = 1;
+    struct sockaddr_in local_addr;
+
+    e_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (e_socket < 0)
+        return 1;
+
+    setsockopt(e_socket, SOL_SOCKET, SO_REUSEADDR, (const char *) &flag, sizeof(int));
+
+    memset(&local_addr, 0, sizeof(struct sockaddr_in));
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_port = htons((u_short) port);
+    local_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // The metrics are not for clients.
+
+    if (bind(e_socket, (struct sockaddr *) &local_addr, sizeof(struct sockaddr_in))
+        || listen(e_socket, METRICS_BACKLOG)
+        || pthread_create(&e_thread, NULL, _metrics_serve, NULL)) {
+        close(e_socket);
+        e_socket = -1;
+        return 1;
+    }
+
+    return 0;
+}
+
+/// Answer scrapes one by one. It runs in its own thread, so a slow scraper delays only other scrapers.
+/// \param arg      Unused.
+void *_metrics_serve(void *arg) {
+    int client_socket;
+    char request[1024];
+    char *snapshot = NULL;
+    struct timeval timeout = {METRICS_TIMEOUT, 0};
+
+    for (;;) {
+        client_socket = accept(e_socket, NULL, NULL);
+        if (client_socket < 0) {
+            if (__atomic_load_n(&e_socket, __ATOMIC_ACQUIRE) < 0)
+                break;
+            continue;
+        }
+
+        setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        // Whatever the request is, the answer is the snapshot.
+        if (recv(client_socket, request, sizeof(request), 0) >= 0) {
+            snapshot = _metrics_snapshot();
+
+            if (!_metrics_send(client_socket, METRICS_HEADER, strlen(METRICS_HEADER)))
+                _metrics_send(client_socket, snapshot, strlen(snapshot));
+
+            memory_free(snapshot, 0);
+        }
+
+        close(client_socket);
+    }
+
+    return NULL;
+}
+
+/// Send all the data.
+/// \param socket   The socket.
+/// \param data     The data.
+/// \param length   Length of the data.
+/// \return         Status code. 0 = Success, 1 = Error.
+int _metrics_send(int socket, char *data, size_t length) {
+    size_t sent;
+    ssize_t result;
+
+    for (sent = 0; sent < length; sent += (size_t) result) {
+        result = send(socket, data + sent, length - sent, MSG_NOSIGNAL);
+        if (result <= 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/// Append a metric with a single value.
+/// \param message  The message.
+/// \param name     Name of the metric.
+/// \param type     Type of the metric.
+/// \param help     Description of the metric.
+/// \param value    The value.
+void _metrics_value(message_t *message, char *name, char *type, char *help, long value) {
+    message_append(message, "# HELP ", 7);
+    message_append(message, name, strlen(name));
+    message_append_char(message, ' ');
+    message_append(message, help, strlen(help));
+    message_append(message, "\n# TYPE ", 8);
+    message_append(message, name, strlen(name));
+    message_append_char(message, ' ');
+    message_append(message, type, strlen(type));
+    message_append_char(message, '\n');
+    message_append(message, name, strlen(name));
+    message_append_char(message, ' ');
+    message_append_int(message, value);
+    message_append_char(message, '\n');
+}
+
+/// Append a sample of the histogram.
+/// \param message  The message.
+/// \param name     Name of the metric including the suffix.
+/// \param command  The command label.
+/// \param le       The bucket label or NULL.
+/// \param value    The value.
+void _metrics_sample(message_t *message, char *name, char *command, char *le, long value) {
+    message_append(message, name, strlen(name));
+    message_append(message, "{command=\"", 10);
+    message_append(message, command, strlen(command));
+    if (le) {
+        message_append(message, "\",le=\"", 6);
+        message_append(message, le, strlen(le));
+    }
+    message_append(message, "\"} ", 3);
+    message_append_int(message, value);
+    message_append_char(message, '\n');
+}
+
+/// Append the header of the histogram metric.
+/// \param message  The message.
+/// \param name     Name of the metric.
+/// \param help     Description of the metric.
+void _metrics_histogram_header(message_t *message, char *name, char *help) {
+    message_append(message, "# HELP ", 7);
+    message_append(message, name, strlen(name));
+    message_append_char(message, ' ');
+    message_append(message, help, strlen(help));
+    message_append(message, "\n# TYPE ", 8);
+    message_append(message, name, strlen(name));
+    message_append(message, " histogram\n", 11);
+}
+
+/// Append samples of the histogram. Buckets are reported at each power of 2.
+/// \param message  The message.
+/// \param name     Name of the metric.
+/// \param command  The command label.
+/// \param histogram The histogram.
+void _metrics_histogram_series(message_t *message, char *name, char *command, stats_histogram_t *histogram) {
+    char sample_name[128];
+    char le[32];
+    long cumulative = 0;
+    int i;
+
+    snprintf(sample_name, sizeof(sample_name), "%s_bucket", name);
+
+    for (i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i) {
+        cumulative += histogram->buckets[i];
+
+        // The last bucket of each power of 2.
+        if (((i + 1) & ((1 << STATS_HISTOGRAM_SUB_BITS) - 1)) == 0 && i + 1 < STATS_HISTOGRAM_BUCKETS) {
+            snprintf(le, sizeof(le), "%ld", _stats_bucket_limit(i));
+            _metrics_sample(message, sample_name, command, le, cumulative);
+        }
+    }
+
+    _metrics_sample(message, sample_name, command, "+Inf", histogram->count);
+
+    snprintf(sample_name, sizeof(sample_name), "%s_sum", name);
+    _metrics_sample(message, sample_name, command, NULL, histogram->sum);
+    snprintf(sample_name, sizeof(sample_name), "%s_count", name);
+    _metrics_sample(message, sample_name, command, NULL, histogram->count);
+}
+
+/// Append the histograms of all commands.
+/// \param message  The message.
+/// \param name     Name of the metric.
+/// \param help     Description of the metric.
+/// \param histograms Histograms of the commands.
+void _metrics_histogram(message_t *message, char *name, char *help, stats_histogram_t *histograms) {
+    int command;
+
+    _metrics_histogram_header(message, name, help);
+
+    for (command = 0; command < STATS_COMMAND_COUNT; ++command)
+        if (histograms[command].count > 0)
+            _metrics_histogram_series(message, name, stats_command_name((stats_command_t) command), &histograms[command]);
+}
+
+/// Build the snapshot in the Prometheus text format. It takes no lock of the game or receive paths.
+/// \return         The snapshot. It has to be freed by memory_free.
+char *_metrics_snapshot() {
+    stats_shard_t *total = NULL;
+    message_t message;
+    long connections = 0;
+    int i;
+
+    total = memory_malloc(sizeof(stats_shard_t), 0);
+    stats_collect(total);
+
+    for (i = 0; i < g_reactor_count; ++i)
+        connections += __atomic_load_n(&g_reactor_list[i].connection_count, __ATOMIC_RELAXED);
+
+    message_init(&message, 16384);
+
+    _metrics_value(&message, "ups_received_messages_total", "counter", "Received messages.", total->counters[STATS_MESSAGES_RECEIVED]);
+    _metrics_value(&message, "ups_received_bytes_total", "counter", "Received bytes.", total->counters[STATS_BYTES_RECEIVED]);
+    _metrics_value(&message, "ups_sent_messages_total", "counter", "Sent messages.", total->counters[STATS_MESSAGES_SENT]);
+    _metrics_value(&message, "ups_sent_bytes_total", "counter", "Sent bytes.", total->counters[STATS_BYTES_SENT]);
+    _metrics_value(&message, "ups_bad_messages_total", "counter", "Received messages with bad form.", total->counters[STATS_MESSAGES_BAD]);
+    _metrics_value(&message, "ups_refused_connections_total", "counter", "Connections closed right after accept, because the server was at its limits.",
+                   total->counters[STATS_CONNECTIONS_REFUSED]);
+    _metrics_value(&message, "ups_handshake_timeouts_total", "counter", "Connections closed, because they did not send the handshake in time.",
+                   total->counters[STATS_HANDSHAKE_TIMEOUTS]);
+    _metrics_value(&message, "ups_heartbeat_evictions_total", "counter", "Connections shut down because they stopped answering pings.",
+                   total->counters[STATS_HEARTBEAT_EVICTIONS]);
+    _metrics_value(&message, "ups_dropped_log_messages_total", "counter", "Log messages dropped because the log ring was full.",
+                   __atomic_load_n(&g_logger_dropped, __ATOMIC_RELAXED));
+
+    _metrics_value(&message, "ups_connections", "gauge", "Open client connections.", connections);
+    _metrics_value(&message, "ups_players", "gauge", "Registered players including the ones waiting for a reconnect.",
+                   __atomic_load_n(&g_metrics_gauges[METRICS_GAUGE_PLAYERS], __ATOMIC_RELAXED));
+    _metrics_value(&message, "ups_players_connected", "gauge", "Connected players.",
+                   __atomic_load_n(&g_metrics_gauges[METRICS_GAUGE_PLAYERS_CONNECTED], __ATOMIC_RELAXED));
+    _metrics_value(&message, "ups_games", "gauge", "Live games.",
+                   __atomic_load_n(&g_metrics_gauges[METRICS_GAUGE_GAMES], __ATOMIC_RELAXED));
+    _metrics_value(&message, "ups_games_in_progress", "gauge", "Games in progress.",
+                   __atomic_load_n(&g_metrics_gauges[METRICS_GAUGE_GAMES_IN_PROGRESS], __ATOMIC_RELAXED));
+    _metrics_value(&message, "ups_games_open", "gauge", "Games listed in the lobby.",
+                   __atomic_load_n(&g_game_open_count, __ATOMIC_RELAXED));
+    _metrics_value(&message, "ups_lobby_open_slots", "gauge", "Free player slots of games listed in the lobby.",
+                   __atomic_load_n(&g_metrics_gauges[METRICS_GAUGE_OPEN_SLOTS], __ATOMIC_RELAXED));
+
+    _metrics_histogram(&message, "ups_request_latency_microseconds", "Time from receiving a request until it is processed.",
+                       total->latency);
+    _metrics_histogram(&message, "ups_sent_message_bytes", "Size of sent messages by the request they answer.",
+                       total->send_size);
+    _metrics_histogram_header(&message, "ups_heartbeat_rtt_microseconds", "Round trip time of pings answered by clients.");
+    _metrics_histogram_series(&message, "ups_heartbeat_rtt_microseconds", stats_command_name(STATS_COMMAND_PONG), &total->heartbeat_rtt);
+
+    memory_free(total, 0);
+
+    return message_finish(&message);
+}
+
+/// Stop answering scrapes.
+void metrics_free() {
+    int socket = __atomic_exchange_n(&e_socket, -1, __ATOMIC_ACQ_REL);
+
+    if (socket < 0)
+        return;
+
+    // Wake the thread blocked in accept.
+    shutdown(socket, SHUT_RDWR);
+    pthread_join(e_thread, NULL);
+    close(socket);
+}
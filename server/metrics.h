@@ -0,0 +1,22 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_METRICS_H
+#define SERVER_METRICS_H
+
+extern long g_metrics_gauges[METRICS_GAUGE_COUNT];
+
+void metrics_gauge_add(metrics_gauge_t gauge, long delta);
+int metrics_init(int port);
+void *_metrics_serve(void *arg);
+int _metrics_send(int socket, char *data, size_t length);
+void _metrics_value(message_t *message, char *name, char *type, char *help, long value);
+void _metrics_sample(message_t *message, char *name, char *command, char *le, long value);
+void _metrics_histogram_header(message_t *message, char *name, char *help);
+void _metrics_histogram_series(message_t *message, char *name, char *command, stats_histogram_t *histogram);
+void _metrics_histogram(message_t *message, char *name, char *help, stats_histogram_t *histograms);
+char *_metrics_snapshot();
+void metrics_free();
+
+#endif //SERVER_METRICS_H
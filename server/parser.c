@@ -0,0 +1,166 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "constants.h"
+#include "structs.h"
+#include "token_hash.h"
+#include "parser.h"
+
+// Perfect hash of the accepted command tokens, generated by tokengen from the token list.
+const unsigned char p_slots[TOKEN_HASH_SIZE] = TOKEN_HASH_SLOTS;
+const char *const p_names[TOKEN_COUNT] = TOKEN_NAMES;
+
+// Kinds of the fields of binary requests which follow the player ID. 'i' = ID, 'n' = number. Fields beyond are numbers.
+const char *const p_fields[TOKEN_COUNT] = {
+        [TOKEN_LOBBY_SUBSCRIBE] = "n",
+        [TOKEN_CREATE_NEW_GAME] = "n",
+        [TOKEN_JOIN_PLAYER_TO_GAME] = "i",
+        [TOKEN_DISCONNECT_PLAYER_FROM_GAME] = "i",
+        [TOKEN_GAME_CHOICE_SELECTED] = "ni",
+        [TOKEN_PONG] = "n",
+};
+
+/// Split the message to tokens in place. Tokens are slices of the message, each of them is null-terminated.
+/// Empty tokens are skipped, as strtok does. The second token is looked up as the command.
+/// It only touches the message and the request, so it is reentrant.
+/// \param message  The message.
+/// \param length   Length of the message.
+/// \param request  Where the tokens are written.
+/// \return         Count of the tokens.
+int parser_split(char *message, unsigned int length, request_t *request) {
+    char *end = message + length;
+    char *separator = NULL;
+
+    request->count = 0;
+
+    while (message < end && request->count < MAX_CLIENT_TOKENS) {
+        separator = memchr(message, ';', (size_t) (end - message));
+        if (!separator)
+            separator = end;
+
+        if (separator > message) {
+            request->tokens[request->count].data = message;
+            request->tokens[request->count].length = (unsigned int) (separator - message);
+            request->count++;
+        }
+
+        *separator = '\0';
+        message = separator + 1;
+    }
+
+    request->command = request->count > 1 ? parser_token(&request->tokens[1]) : TOKEN_COUNT;
+
+    return request->count;
+}
+
+/// Seeded FNV-1a hash of the token. It must be the same as the one of tokengen.
+/// \param data     The token.
+/// \param length   Length of the token.
+/// \param seed     The seed.
+/// \return         The hash.
+unsigned int _parser_hash(const char *data, unsigned int length, unsigned int seed) {
+    unsigned int hash = 2166136261u ^ seed;
+    unsigned int i;
+
+    for (i = 0; i < length; ++i) {
+        hash ^= (unsigned char) data[i];
+        hash *= 16777619u;
+    }
+
+    return hash ^ (hash >> 16);
+}
+
+/// Find the command of the token. The token falls into a single slot, so one comparison tells if it is the command.
+/// \param slice    The token.
+/// \return         The command or TOKEN_COUNT if the token is not a command.
+token_t parser_token(slice_t *slice) {
+    unsigned int slot = _parser_hash(slice->data, slice->length, TOKEN_HASH_SEED) & (TOKEN_HASH_SIZE - 1);
+    token_t token = (token_t) p_slots[slot];
+
+    if (token == TOKEN_COUNT || strncmp(p_names[token], slice->data, slice->length) != 0 || p_names[token][slice->length])
+        return TOKEN_COUNT;
+
+    return token;
+}
+
+/// Read the varint. Each byte holds 7 bits, the lowest first, the highest bit tells if another byte follows.
+/// \param data     The data.
+/// \param length   Length of the data.
+/// \param value    Where the value is written.
+/// \return         Count of read bytes or 0 if the varint is cut off or longer than 64 bits.
+unsigned int _parser_varint(const unsigned char *data, unsigned int length, unsigned long *value) {
+    unsigned int i;
+
+    *value = 0;
+
+    for (i = 0; i < length && i < 10; ++i) {
+        *value |= (unsigned long) (data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80))
+            return i + 1;
+    }
+
+    return 0;
+}
+
+/// Decode the binary frame into the same tokens the text message has, so the request is served by the same handlers.
+/// The frame is the command (one byte, its index in the token list), the player ID and the fields of the command, all of them varints.
+/// IDs are written as hex and numbers as decimal into the storage of the request.
+/// \param frame    The frame.
+/// \param length   Length of the frame.
+/// \param request  Where the tokens are written. The command is TOKEN_COUNT if the frame is malformed.
+/// \return         Count of the tokens.
+int parser_decode(char *frame, unsigned int length, request_t *request) {
+    const unsigned char *data = (const unsigned char *) frame;
+    const char *kinds = NULL;
+    char *storage = request->storage;
+    unsigned long value;
+    unsigned int position = 1;
+    unsigned int size;
+    token_t token;
+
+    request->count = 0;
+    request->command = TOKEN_COUNT;
+
+    if (length == 0 || data[0] >= TOKEN_COUNT)
+        return 0;
+
+    token = (token_t) data[0];
+    kinds = p_fields[token] ? p_fields[token] : "";
+
+    // The player ID and the command are the first tokens, as in the text message.
+    size = _parser_varint(data + position, length - position, &value);
+    if (!size)
+        return 0;
+    position += size;
+
+    request->tokens[0].data = storage;
+    request->tokens[0].length = (unsigned int) sprintf(storage, "%016lx", value);
+    storage += request->tokens[0].length + 1;
+
+    request->tokens[1].data = (char *) p_names[token];
+    request->tokens[1].length = (unsigned int) strlen(p_names[token]);
+    request->count = 2;
+
+    // Fields which do not fit are ignored, as the text ones are.
+    while (position < length && request->count < MAX_CLIENT_TOKENS) {
+        size = _parser_varint(data + position, length - position, &value);
+        if (!size)
+            return request->count;
+        position += size;
+
+        request->tokens[request->count].data = storage;
+        request->tokens[request->count].length = (unsigned int) sprintf(storage, *kinds == 'i' ? "%016lx" : "%lu", value);
+        storage += request->tokens[request->count].length + 1;
+        request->count++;
+
+        if (*kinds)
+            kinds++;
+    }
+
+    request->command = token;
+
+    return request->count;
+}
@@ -0,0 +1,14 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_PARSER_H
+#define SERVER_PARSER_H
+
+int parser_split(char *message, unsigned int length, request_t *request);
+unsigned int _parser_hash(const char *data, unsigned int length, unsigned int seed);
+token_t parser_token(slice_t *slice);
+unsigned int _parser_varint(const unsigned char *data, unsigned int length, unsigned long *value);
+int parser_decode(char *frame, unsigned int length, request_t *request);
+
+#endif //SERVER_PARSER_H
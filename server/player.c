@@ -15,97 +15,304 @@
 #include "game.h"
 #include "colors.h"
 #include "game_logic.h"
+#include "table.h"
+#include "id.h"
+#include "lobby.h"
+#include "metrics.h"
+#include "reactor.h"
+#include "timer.h"
+
+// Lost players whose timer expired, the sweep removes them all at once.
+player_t *p_expired_list = NULL;
+pthread_mutex_t p_expired_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Key of the player in the player table.
+/// \param item     The player.
+/// \return         Player ID.
+char *_player_key_id(void *item) {
+    return ((player_t *) item)->id;
+}
+
+/// Key of the player in the client address index.
+/// \param item     The player.
+/// \return         Client address.
+char *_player_key_client_addr(void *item) {
+    return ((player_t *) item)->client_addr;
+}
+
+/// Initialize the player registry.
+void player_init() {
+    table_init(&g_player_table, _player_key_id);
+    table_init(&g_player_addr_table, _player_key_client_addr);
+}
 
 /// Create a player struct.
-/// \param connection_info  Connection info struct.
+/// \param connection       The connection of the player.
 /// \param nickname         Player nickname.
 /// \return                 Player struct.
-player_t *player_create(remote_connection_t *connection_info, char *nickname) {
+player_t *player_create(connection_t *connection, char *nickname) {
     player_t *p = memory_malloc(sizeof(player_t), 0);
 
-    p->nickname = memory_malloc(50 * sizeof(char), 0);
-    sprintf(p->nickname, "%s", nickname);
-
-    p->client_addr = memory_malloc(connection_info->client_address_len * sizeof(char), 0);
-    sprintf(p->client_addr, "%s", connection_info->client_address);
+    snprintf(p->nickname, sizeof(p->nickname), "%s", nickname);
+    p->nickname_length = (int) strlen(p->nickname);
+    snprintf(p->client_addr, sizeof(p->client_addr), "%s", connection->client_address);
 
     p->choice = 0;
-    p->socket = connection_info->client_socket;
+    p->connection = NULL;
+    pthread_mutex_init(&p->mutex, NULL);
+    p->reference_count = 1; // The player table holds it.
+    p->is_removed = 0;
+    player_set_connection(p, connection);
+    p->lost_at = 0;
+    timer_entry_init(&p->lost_timer, _player_lost_expired, p);
+    p->expired_next = NULL;
+    p->is_expired = 0;
     p->is_disconnected = 0;
-    p->id = svr_generate_id();
-    p->next = NULL;
+    id_generate(p->id);
+    p->addr_next = NULL;
+    p->addr_prev = NULL;
+    p->is_subscribed = 0;
+    p->lobby_mode = LOBBY_MODE_SNAPSHOT;
+    p->lobby_version = LOBBY_VERSION_NONE;
+    p->lobby_next = NULL;
+    p->lobby_prev = NULL;
     p->game = NULL;
 
+    reactor_connection_set_player(connection, p);
+
     return p;
 }
 
-/// Change player's socket to another.
-/// \param player   The player.
-/// \param socket   The socket.
-void player_change_socket(player_t *player, int socket) {
-    player->socket = socket;
+/// Change player's connection to another.
+/// \param player       The player.
+/// \param connection   The connection.
+void player_change_socket(player_t *player, connection_t *connection) {
+    connection_t *previous = player_get_connection(player);
+
+    // Detach the previous connection, if the server did not notice it is broken yet.
+    if (previous && previous != connection)
+        reactor_connection_set_player(previous, NULL);
+    reactor_connection_release(previous);
+
+    player_set_connection(player, connection);
+    player->lost_at = 0;
+    reactor_connection_set_player(connection, player);
+
+    // The player is back, the lost timer does not hold it anymore.
+    if (timer_cancel(&player->lost_timer))
+        player_release(player);
 }
 
-/// Remove the player from the player list.
+/// Set the connection of the player. The player holds a reference of it.
+/// \param player       The player.
+/// \param connection   The connection or NULL.
+void player_set_connection(player_t *player, connection_t *connection) {
+    connection_t *previous = NULL;
+
+    if (connection)
+        reactor_connection_hold(connection);
+
+    pthread_mutex_lock(&player->mutex);
+    previous = player->connection;
+    player->connection = connection;
+    pthread_mutex_unlock(&player->mutex);
+
+    reactor_connection_release(previous);
+}
+
+/// Detach the connection from the player, unless the player has moved to another connection meanwhile.
+/// \param player       The player.
+/// \param connection   The connection.
+/// \return             Status code. 0 = Success, 1 = The player does not have the connection.
+int player_detach_connection(player_t *player, connection_t *connection) {
+    int status = 1;
+
+    pthread_mutex_lock(&player->mutex);
+    if (player->connection == connection) {
+        player->connection = NULL;
+        status = 0;
+    }
+    pthread_mutex_unlock(&player->mutex);
+
+    if (!status)
+        reactor_connection_release(connection);
+
+    return status;
+}
+
+/// Get the connection of the player. The connection is held, it has to be released by reactor_connection_release.
+/// \param player       The player.
+/// \return             The connection or NULL.
+connection_t *player_get_connection(player_t *player) {
+    connection_t *connection = NULL;
+
+    pthread_mutex_lock(&player->mutex);
+    connection = player->connection;
+    if (connection)
+        reactor_connection_hold(connection);
+    pthread_mutex_unlock(&player->mutex);
+
+    return connection;
+}
+
+/// Set the game of the player. The player holds a reference of it. Call it from the game events.
+/// \param player       The player.
+/// \param game         The game or NULL.
+void _player_set_game(player_t *player, game_t *game) {
+    game_t *previous = NULL;
+
+    if (game)
+        game_hold(game);
+
+    pthread_mutex_lock(&player->mutex);
+    previous = player->game;
+    player->game = game;
+    pthread_mutex_unlock(&player->mutex);
+
+    game_release(previous);
+}
+
+/// Claim the player for the game, unless the player is removed or it is in another game. The player holds a reference of the game.
+/// Games run on different shards, the claim keeps the player in one game only.
+/// \param player       The player.
+/// \param game         The game.
+/// \return             Status code. 0 = Success, 1 = Error.
+int _player_claim_game(player_t *player, game_t *game) {
+    int status = 0;
+
+    pthread_mutex_lock(&player->mutex);
+
+    if (player->is_removed || (player->game && player->game != game)) {
+        status = 1;
+    } else if (!player->game) {
+        game_hold(game);
+        player->game = game;
+    }
+
+    pthread_mutex_unlock(&player->mutex);
+
+    return status;
+}
+
+/// Get the game of the player. The game is held, it has to be released by game_release.
+/// \param player       The player.
+/// \return             The game or NULL.
+game_t *player_get_game(player_t *player) {
+    game_t *game = NULL;
+
+    pthread_mutex_lock(&player->mutex);
+    game = player->game;
+    if (game)
+        game_hold(game);
+    pthread_mutex_unlock(&player->mutex);
+
+    return game;
+}
+
+/// Take a reference to the player. The player is destroyed when the last reference is released.
+/// \param player       The player.
+void player_hold(player_t *player) {
+    __atomic_fetch_add(&player->reference_count, 1, __ATOMIC_RELAXED);
+}
+
+/// Release the reference to the player.
+/// \param player       The player or NULL.
+void player_release(player_t *player) {
+    if (player && __atomic_sub_fetch(&player->reference_count, 1, __ATOMIC_ACQ_REL) == 0)
+        _player_destroy(player);
+}
+
+/// Send the message to the player, if the player has a connection.
+/// \param player                   The player.
+/// \param message                  The message.
+/// \param is_broadcast_message     Tells, if it is single message or broadcast the same messages to multiple clients.
+void player_send(player_t *player, char *message, int is_broadcast_message) {
+    connection_t *connection = player_get_connection(player);
+
+    svr_send(connection, message, is_broadcast_message);
+    reactor_connection_release(connection);
+}
+
+/// Send the buffer to the player, if the player has a connection.
+/// \param player                   The player.
+/// \param buffer                   The buffer.
+/// \param offset                   Where the sent part of the buffer starts.
+/// \param is_broadcast_message     Tells, if it is single message or broadcast the same messages to multiple clients.
+void player_send_buffer(player_t *player, buffer_t *buffer, size_t offset, int is_broadcast_message) {
+    connection_t *connection = player_get_connection(player);
+
+    svr_send_buffer(connection, buffer, offset, is_broadcast_message);
+    reactor_connection_release(connection);
+}
+
+/// Remove the player from the player list. The game of the player lets it go by an event.
 /// \param player
 void player_remove(player_t *player) {
     if (!player)
         return;
 
-    char *id = memory_malloc(sizeof(char) * (19 + 1), 0);
+    char id[ID_LENGTH + 1];
     strcpy(id, player->id);
-    int socket = player->socket;
+    connection_t *connection = player_get_connection(player);
+    game_t *game = NULL;
     int is_disconnected = player->is_disconnected;
+    int is_removed = 0;
     char *log_message = NULL;
     char *message = NULL;
-    player_t *previous = NULL;
-    player_t *ptr = NULL;
 
-    ptr = g_player_list;
+    // The connection stays opened until the client closes it, but it does not belong to the player anymore.
+    if (connection)
+        reactor_connection_set_player(connection, NULL);
 
     log_message = memory_malloc(sizeof(char) * 256, 0);
     sprintf(log_message, "\t> Player %s (ID: %s) has disconnected!\n", player->nickname, player->id);
 
-    pthread_mutex_lock(&g_player_list_mutex);
-
-    do {
-        if (strcmp(ptr->id, id) == 0) {
-            if (!previous) {
-                if (ptr->next == NULL) {
-                    _player_destroy(ptr);
-                    g_player_list = NULL;
-                } else {
-                    g_player_list = ptr->next;
-                    _player_destroy(ptr);
-                    ptr = NULL;
-                }
-            } else {
-                previous->next = ptr->next;
-                _player_destroy(ptr);
-                ptr = NULL;
-            }
-        }
+    // The player cannot join any game from now on and it is not subscribed to the lobby again.
+    pthread_mutex_lock(&player->mutex);
+    __atomic_store_n(&player->is_removed, 1, __ATOMIC_RELEASE);
+    game = player->game;
+    if (game)
+        game_hold(game);
+    pthread_mutex_unlock(&player->mutex);
 
-        if (ptr) {
-            previous = ptr;
-            ptr = ptr->next;
-        }
+    pthread_rwlock_wrlock(&g_player_table_lock);
+
+    if (table_remove(&g_player_table, player)) {
+        if (player->is_disconnected == 1)
+            _player_addr_index_remove(player);
+        else
+            metrics_gauge_add(METRICS_GAUGE_PLAYERS_CONNECTED, -1);
+        metrics_gauge_add(METRICS_GAUGE_PLAYERS, -1);
+
+        is_removed = 1;
+    }
+
+    pthread_rwlock_unlock(&g_player_table_lock);
 
-    } while (ptr);
+    game_post(game, GAME_EVENT_LEAVE, player, 0);
+    game_release(game);
 
-    pthread_mutex_unlock(&g_player_list_mutex);
+    if (timer_cancel(&player->lost_timer))
+        player_release(player);
+
+    // The player has been already removed by someone else. Games and events holding the player keep it until they are done.
+    if (is_removed) {
+        lobby_unsubscribe(player);
+        player_release(player);
+    }
 
     message = memory_malloc(sizeof(char) * 256, 0);
     sprintf(message, "%s;disconnect_player\n", id); // Token message.
 
-    if (is_disconnected != 1)
-        svr_send(socket, message, 0);
+    if (is_removed && is_disconnected != 1)
+        svr_send(connection, message, 0);
 
-    write_log(log_message);
+    if (is_removed)
+        write_log(log_message);
 
     memory_free(log_message, 0);
     memory_free(message, 0);
-    memory_free(id, 0);
+    reactor_connection_release(connection);
 }
 
 /// Free all the needed memory space to be able to delete a pointer to the player without filled memory with its data. (Delete the player).
@@ -114,13 +321,12 @@ void _player_destroy(player_t *player) {
     if (!player)
         return;
 
-    memory_free(player->id, 0);
-    memory_free(player->nickname, 0);
-    memory_free(player->client_addr, 0);
+    player_set_connection(player, NULL);
+    pthread_mutex_destroy(&player->mutex);
     memory_free(player, 0);
 }
 
-/// Find the player in the player list by ID.
+/// Find the player in the player list by ID. The player is held, it has to be released by player_release.
 /// \param id       Player ID.
 /// \return         Pointer to player. Returns NULL if it fails.
 player_t *player_find(char *id) {
@@ -129,28 +335,16 @@ player_t *player_find(char *id) {
 
     player_t *player_ptr = NULL;
 
-    pthread_mutex_lock(&g_player_list_mutex);
-
-    if (g_player_list != NULL) {
-        player_ptr = g_player_list;
-
-        do {
-            if (strcmp(player_ptr->id, id) == 0) {
-                pthread_mutex_unlock(&g_player_list_mutex);
-                return player_ptr;
-            }
-
-            player_ptr = player_ptr->next;
+    pthread_rwlock_rdlock(&g_player_table_lock);
+    player_ptr = table_find(&g_player_table, id);
+    if (player_ptr)
+        player_hold(player_ptr);
+    pthread_rwlock_unlock(&g_player_table_lock);
 
-        } while (player_ptr != NULL);
-    }
-
-    pthread_mutex_unlock(&g_player_list_mutex);
-
-    return NULL;
+    return player_ptr;
 }
 
-/// Find the player in the player list by Client addr.
+/// Find a disconnected player in the player list by Client addr. The player is held, it has to be released by player_release.
 /// \param id       Client addr.
 /// \return         Pointer to player. Returns NULL if it fails.
 player_t *player_find_unknown_reconnect(char *client_addr) {
@@ -159,25 +353,144 @@ player_t *player_find_unknown_reconnect(char *client_addr) {
 
     player_t *player_ptr = NULL;
 
-    pthread_mutex_lock(&g_player_list_mutex);
+    // Only disconnected players are indexed by the address.
+    pthread_rwlock_rdlock(&g_player_table_lock);
+    player_ptr = table_find(&g_player_addr_table, client_addr);
+    if (player_ptr)
+        player_hold(player_ptr);
+    pthread_rwlock_unlock(&g_player_table_lock);
 
-    if (g_player_list != NULL) {
-        player_ptr = g_player_list;
+    return player_ptr;
+}
 
-        do {
-            if (player_ptr->is_disconnected == 1 && strcmp(player_ptr->client_addr, client_addr) == 0) {
-                pthread_mutex_unlock(&g_player_list_mutex);
-                return player_ptr;
-            }
+/// Change the connection status of the player and keep the client address index up to date.
+/// \param player           The player.
+/// \param is_disconnected  1 = Player is disconnected, 0 = Player is connected.
+void player_set_disconnected(player_t *player, int is_disconnected) {
+    if (!player || player->is_disconnected == is_disconnected)
+        return;
+
+    pthread_rwlock_wrlock(&g_player_table_lock);
 
-            player_ptr = player_ptr->next;
+    if (player->is_disconnected != is_disconnected) {
+        player->is_disconnected = is_disconnected;
 
-        } while (player_ptr != NULL);
+        // The player may be not registered yet or already removed.
+        if (table_find(&g_player_table, player->id) == player) {
+            if (is_disconnected == 1)
+                _player_addr_index_add(player);
+            else
+                _player_addr_index_remove(player);
+            metrics_gauge_add(METRICS_GAUGE_PLAYERS_CONNECTED, is_disconnected == 1 ? -1 : 1);
+        }
     }
 
-    pthread_mutex_unlock(&g_player_list_mutex);
+    pthread_rwlock_unlock(&g_player_table_lock);
+}
 
-    return NULL;
+/// Add the player into the client address index. The table holds the first player of each address, the rest is chained to it.
+/// Call it with the player table lock.
+/// \param player   The player.
+void _player_addr_index_add(player_t *player) {
+    player_t *head = table_find(&g_player_addr_table, player->client_addr);
+
+    player->addr_prev = NULL;
+    player->addr_next = NULL;
+
+    if (!head) {
+        table_add(&g_player_addr_table, player);
+        return;
+    }
+
+    // Chain the player right after the head.
+    player->addr_prev = head;
+    player->addr_next = head->addr_next;
+    if (head->addr_next)
+        head->addr_next->addr_prev = player;
+    head->addr_next = player;
+}
+
+/// Remove the player from the client address index.
+/// Call it with the player table lock.
+/// \param player   The player.
+void _player_addr_index_remove(player_t *player) {
+    if (player->addr_prev) {
+        player->addr_prev->addr_next = player->addr_next;
+        if (player->addr_next)
+            player->addr_next->addr_prev = player->addr_prev;
+
+    } else if (table_remove(&g_player_addr_table, player) && player->addr_next) {
+        // The next player of the same address becomes the head.
+        player->addr_next->addr_prev = NULL;
+        table_add(&g_player_addr_table, player->addr_next);
+    }
+
+    player->addr_prev = NULL;
+    player->addr_next = NULL;
+}
+
+/// Mark the player as lost. It is removed, unless it reconnects in time.
+/// The player waits in the timer wheel, the pending timer holds it.
+/// \param player   The player.
+/// \param timeout  Seconds the player may reconnect in.
+void player_set_lost(player_t *player, int timeout) {
+    time(&player->lost_at);
+
+    player_hold(player);
+    if (timer_cancel(&player->lost_timer))
+        player_release(player);
+
+    timer_schedule(&player->lost_timer, timeout * 1000L);
+}
+
+/// The lost player did not reconnect in time. It runs on the timer thread, so the player is only queued for the sweep.
+/// A player still queued from its previous expiry is not queued twice, the reference of the timer is dropped instead.
+/// \param timer    The lost timer of the player.
+void _player_lost_expired(timer_entry_t *timer) {
+    player_t *player = (player_t *) timer->data;
+    int is_queued;
+
+    pthread_mutex_lock(&p_expired_mutex);
+    is_queued = player->is_expired;
+    if (!is_queued) {
+        player->is_expired = 1;
+        player->expired_next = p_expired_list;
+        p_expired_list = player;
+    }
+    pthread_mutex_unlock(&p_expired_mutex);
+
+    // The queue holds the player by the reference of the first expiry.
+    if (is_queued)
+        player_release(player);
+}
+
+/// Remove players whose lost timer expired. Only the expired ones are visited, all of them at once.
+void player_expire_lost() {
+    player_t *expired = NULL;
+    player_t *next = NULL;
+    connection_t *connection = NULL;
+
+    pthread_mutex_lock(&p_expired_mutex);
+    expired = p_expired_list;
+    p_expired_list = NULL;
+    pthread_mutex_unlock(&p_expired_mutex);
+
+    for (; expired; expired = next) {
+        // The player may be queued again once it is taken out of the list.
+        pthread_mutex_lock(&p_expired_mutex);
+        next = expired->expired_next;
+        expired->expired_next = NULL;
+        expired->is_expired = 0;
+        pthread_mutex_unlock(&p_expired_mutex);
+
+        // The player may have reconnected meanwhile, or it got lost again and the new timer expires it later.
+        connection = player_get_connection(expired);
+        if (!connection && expired->lost_at && !timer_is_pending(&expired->lost_timer))
+            player_remove(expired);
+        reactor_connection_release(connection);
+
+        player_release(expired);
+    }
 }
 
 /// Add a new player into player list.
@@ -186,26 +499,52 @@ void player_add(player_t *player) {
     if (!player)
         return;
 
-    pthread_mutex_lock(&g_player_list_mutex);
+    pthread_rwlock_wrlock(&g_player_table_lock);
 
-    if (g_player_list == NULL) {
-        // There is no other player, let's add a new (the first) one.
-        g_player_list = player;
-    } else {
-        // There are already some players created, let's add a new one at the end of the player list.
-        player_t *ptr = g_player_list;
+    table_add(&g_player_table, player);
+    if (player->is_disconnected == 1)
+        _player_addr_index_add(player);
+    else
+        metrics_gauge_add(METRICS_GAUGE_PLAYERS_CONNECTED, 1);
+    metrics_gauge_add(METRICS_GAUGE_PLAYERS, 1);
 
-        while (ptr->next != NULL) {
-            ptr = ptr->next;
-        }
+    pthread_rwlock_unlock(&g_player_table_lock);
 
-        ptr->next = player;
-    }
+    // New players start in the lobby.
+    if (!player->game)
+        lobby_subscribe(player);
+}
 
-    pthread_mutex_unlock(&g_player_list_mutex);
+/// Ask the game to let the player join. The game handles it by an event and tells the player if it cannot join.
+/// \param player       The player.
+/// \param game         The game or NULL.
+/// \return             Status code. 0 = Success, 1 = Error.
+int player_join_game(player_t *player, game_t *game) {
+    if (!player || !game)
+        return 1;
+
+    game_post(game, GAME_EVENT_JOIN, player, 0);
+
+    return 0;
+}
+
+/// Ask the game of the player to let the player go. Nothing happens if the player is not in the game by then.
+/// \param player       The player.
+/// \param game         The game or NULL for the current game of the player.
+void player_leave_game(player_t *player, game_t *game) {
+    game_t *current = NULL;
+
+    if (!player)
+        return;
+
+    current = player_get_game(player);
+    if (current && (!game || game == current))
+        game_post(current, GAME_EVENT_LEAVE, player, 0);
+
+    game_release(current);
 }
 
-/// Connects a player to a game.
+/// Connects a player to a game. Call it from the game events or before the game is listed.
 /// \param player       The player.
 /// \param game         The game.
 /// \return             Status code. 0 = Success, 1 = Error.
@@ -218,30 +557,34 @@ int player_connect_to_game(player_t *player, game_t *game) {
     char *message = NULL;
     char *log_message = NULL;
 
-    // Check for reconnection.
-    for (i = 0; i < game->player_count; ++i) {
-        printf("%s - %s\n", player->id, game->players[i]->id);
-        if (strcmp(player->id, game->players[i]->id) == 0) {
+    // Check for reconnection. Slots of players who left are empty.
+    for (i = 0; i < PLAYER_COUNT; ++i) {
+        if (game->players[i] == player) {
             is_reconnecting = 1;
             break;
         }
     }
 
     if (!is_reconnecting) {
-        if (game->player_count >= PLAYER_COUNT)
+        if (game->player_count >= PLAYER_COUNT || _player_claim_game(player, game))
             return 1;
 
         for (i = 0; i < PLAYER_COUNT; ++i) {
             if (game->players[i] != NULL)
                 continue;
 
+            // The game holds its players.
+            player_hold(player);
             game->players[i] = player;
             player->color = g_color_list[i];
             game->player_count++;
-            player->game = game;
             break;
         }
 
+        lobby_unsubscribe(player);
+        game_update_open(game);
+        game_broadcast_update_games();
+
         game_logic_prepare_player_on_game_join(player); // Only for new players /We do not want to reset score to rejoined player f.e.
     }
 
@@ -249,7 +592,7 @@ int player_connect_to_game(player_t *player, game_t *game) {
     memset(message, 0, strlen(message));
     sprintf(message, "%s;prepare_window_for_game;%s;%s;%d\n", player->id, game->id, game->name,
             game->goal); // Token message.
-    svr_send(player->socket, message, 0);
+    player_send(player, message, 0);
 
     log_message = memory_malloc(sizeof(char) * 256, 0);
     if (is_reconnecting)
@@ -260,9 +603,11 @@ int player_connect_to_game(player_t *player, game_t *game) {
 
     game_send_update_players(game);
     if (game->player_count == PLAYER_COUNT) {
-        game_broadcast_update_games();
+        if (is_reconnecting && game->in_progress) {
+            // The round starts over, so the returning player gets the turn.
+            game_post(game, GAME_EVENT_ROUND_START, NULL, 0);
 
-        if (game_start(game)) { // If the game cannot start a thread for it.
+        } else if (game_start(game)) { // If the game cannot be started.
             log_message = memory_malloc(sizeof(char) * 256, 0);
             sprintf(log_message, "\t> Fatal ERROR during creating a new thread!\n");
             write_log(log_message);
@@ -281,7 +626,7 @@ int player_connect_to_game(player_t *player, game_t *game) {
     return 0;
 }
 
-/// Disconnects a player from its current game.
+/// Disconnects a player from its current game. Call it from the game events.
 /// \param player       The player.
 /// \param game         The game.
 void player_disconnect_from_game(player_t *player, game_t *game) {
@@ -289,6 +634,7 @@ void player_disconnect_from_game(player_t *player, game_t *game) {
         return;
 
     int i;
+    int is_member = 0;
     char *log_message = NULL;
     char *message = NULL;
 
@@ -296,12 +642,19 @@ void player_disconnect_from_game(player_t *player, game_t *game) {
         if (game->players[i] == player) {
             game->players[i] = NULL;
             game->player_count--;
-            player->game = NULL;
             player->color = NULL;
+            is_member = 1;
             break;
         }
     }
 
+    game_update_open(game);
+    lobby_subscribe(player);
+
+    // The player is back in the lobby, unless it is removed meanwhile.
+    if (is_member)
+        _player_set_game(player, NULL);
+
 //    if (game->in_progress)
 //        sem_post(&game->sem_on_turn);
 
@@ -318,12 +671,13 @@ void player_disconnect_from_game(player_t *player, game_t *game) {
     message = memory_malloc(sizeof(char) * 256, 0);
     sprintf(message, "%s;leave_game\n", player->id); // Token message.
 
-    // Do not disconnect the player who lost a connection.
-    if (player->is_disconnected != 1)
-        svr_send(player->socket, message, 0);
+    // Do not disconnect the player who lost a connection. The removed one is told it is disconnected already.
+    if (player->is_disconnected != 1 && !__atomic_load_n(&player->is_removed, __ATOMIC_ACQUIRE))
+        player_send(player, message, 0);
 
     // If there is no player, remove the game. Or update information.
     if (game->player_count == 0) {
+        game->state = GAME_STATE_OVER; // Nobody may join the removed game.
         game_remove(game);
     } else {
         game_send_update_players(game);
@@ -331,29 +685,70 @@ void player_disconnect_from_game(player_t *player, game_t *game) {
     }
 
     memory_free(message, 0);
+
+    // The game does not hold the player anymore.
+    if (is_member)
+        player_release(player);
 }
 
 /// Free al players.
 void player_free() {
-    while (g_player_list) {
-        player_remove(g_player_list);
+    int i;
+    int count;
+    unsigned int index = 0;
+    player_t *ptr = NULL;
+    player_t **players = NULL;
+    game_t *game = NULL;
+
+    pthread_rwlock_rdlock(&g_player_table_lock);
+
+    count = g_player_table.count;
+    if (count)
+        players = memory_malloc(sizeof(player_t *) * count, 0);
+
+    for (i = 0; i < count && (ptr = table_iterate(&g_player_table, &index)); ++i)
+        players[i] = ptr;
+
+    pthread_rwlock_unlock(&g_player_table_lock);
+
+    // Reactors and the scheduler are stopped, nothing would be sent anymore and players leave their games right away.
+    for (i = 0; i < count; ++i) {
+        player_hold(players[i]);
+        player_set_connection(players[i], NULL);
+
+        game = player_get_game(players[i]);
+        if (game)
+            player_disconnect_from_game(players[i], game);
+        game_release(game);
+
+        player_remove(players[i]);
+        player_release(players[i]);
     }
+
+    // The timer is stopped, lost timers expired and the players they hold are removed already.
+    player_expire_lost();
+
+    memory_free(players, 0);
+
+    table_free(&g_player_table);
+    table_free(&g_player_addr_table);
 }
 
 /// Print the player.
 void player_print() {
-    player_t *ptr = g_player_list;
+    unsigned int index = 0;
+    player_t *ptr = NULL;
 
     printf("========= PLAYER LIST =========\n");
 
-    if (g_player_list) {
-        do {
-            printf("Nickname: %s (ID: %s)\n", ptr->nickname, ptr->id);
-            //printf("DEBUG: Socket: %d, Client addr.: %s, Is Disconnected status: %d.\n", ptr->socket, ptr->client_addr, ptr->is_disconnected);
-            ptr = ptr->next;
+    pthread_rwlock_rdlock(&g_player_table_lock);
 
-        } while (ptr);
+    while ((ptr = table_iterate(&g_player_table, &index))) {
+        printf("Nickname: %s (ID: %s)\n", ptr->nickname, ptr->id);
+        //printf("DEBUG: Socket: %d, Client addr.: %s, Is Disconnected status: %d.\n", ptr->socket, ptr->client_addr, ptr->is_disconnected);
     }
 
+    pthread_rwlock_unlock(&g_player_table_lock);
+
     printf("===============================\n");
 }
\ No newline at end of file
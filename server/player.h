@@ -5,13 +5,34 @@
 #ifndef SERVER_PLAYER_H
 #define SERVER_PLAYER_H
 
-player_t *player_create(remote_connection_t *connection_info, char *nickname);
-void player_change_socket(player_t *player, int socket);
+char *_player_key_id(void *item);
+char *_player_key_client_addr(void *item);
+void player_init();
+player_t *player_create(connection_t *connection, char *nickname);
+void player_change_socket(player_t *player, connection_t *connection);
+void player_set_connection(player_t *player, connection_t *connection);
+int player_detach_connection(player_t *player, connection_t *connection);
+connection_t *player_get_connection(player_t *player);
+void _player_set_game(player_t *player, game_t *game);
+int _player_claim_game(player_t *player, game_t *game);
+game_t *player_get_game(player_t *player);
+void player_hold(player_t *player);
+void player_release(player_t *player);
+void player_send(player_t *player, char *message, int is_broadcast_message);
+void player_send_buffer(player_t *player, buffer_t *buffer, size_t offset, int is_broadcast_message);
 void player_remove(player_t *player);
 void _player_destroy(player_t *player);
 player_t *player_find(char *id);
 player_t *player_find_unknown_reconnect(char *client_addr);
+void player_set_disconnected(player_t *player, int is_disconnected);
+void _player_addr_index_add(player_t *player);
+void _player_addr_index_remove(player_t *player);
+void player_set_lost(player_t *player, int timeout);
+void _player_lost_expired(timer_entry_t *timer);
+void player_expire_lost();
 void player_add(player_t *player);
+int player_join_game(player_t *player, game_t *game);
+void player_leave_game(player_t *player, game_t *game);
 int player_connect_to_game(player_t *player, game_t *game);
 void player_disconnect_from_game(player_t *player, game_t *game);
 void player_free();
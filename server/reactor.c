@@ -0,0 +1,746 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#define _GNU_SOURCE // accept4, SO_REUSEPORT and thread affinity.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "constants.h"
+#include "structs.h"
+#include "reactor.h"
+#include "server.h"
+#include "memory.h"
+#include "stats.h"
+#include "player.h"
+#include "frame.h"
+#include "buffer.h"
+#include "scheduler.h"
+#include "heartbeat.h"
+
+reactor_t g_reactor_list[REACTOR_THREAD_COUNT];
+int g_reactor_count = 0;
+
+// Index of the reactor which gets the next accepted connection.
+unsigned int r_next_reactor = 0;
+
+// Open connections of all reactors and the most of them admitted.
+long r_connection_total = 0;
+long r_connection_limit = CONNECTION_LIMIT;
+
+/// Number of reactors to start, one per core the server is allowed to run on.
+/// \return         The count.
+int reactor_count() {
+    cpu_set_t cpus;
+    int count = 1;
+
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpus) == 0)
+        count = CPU_COUNT(&cpus);
+
+    if (count < 1)
+        count = 1;
+
+    return count < REACTOR_THREAD_COUNT ? count : REACTOR_THREAD_COUNT;
+}
+
+/// Create epoll instances and start a thread for each reactor. Each thread is pinned to its own core.
+/// The reactor also runs the game events of its scheduler shard, so start the scheduler first.
+void reactor_init() {
+    int i;
+    int cpu = -1;
+    reactor_t *reactor = NULL;
+    cpu_set_t cpus;
+    cpu_set_t affinity;
+    struct epoll_event event;
+    struct rlimit limit;
+
+    g_reactor_count = reactor_count();
+
+    // Keep some descriptors for files, listeners and the metrics, so accept itself never runs out of them.
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+        && (long) limit.rlim_cur - 64 < r_connection_limit)
+        r_connection_limit = (long) limit.rlim_cur > 128 ? (long) limit.rlim_cur - 64 : (long) limit.rlim_cur / 2;
+
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpus))
+        CPU_ZERO(&cpus);
+
+    for (i = 0; i < g_reactor_count; ++i) {
+        reactor = &g_reactor_list[i];
+
+        reactor->index = i;
+        reactor->listen_socket = -1;
+        reactor->is_running = 1;
+        reactor->connection_list = NULL;
+        reactor->connection_count = 0;
+        reactor->handshake_count = 0;
+        time(&reactor->last_sweep);
+        pthread_mutex_init(&reactor->mutex, NULL);
+
+        reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (reactor->epoll_fd < 0) {
+            printf("\t> Epoll: ERROR!\n");
+            exit(1);
+        }
+
+        // The shard wakes the reactor up when its games have events to run.
+        memset(&event, 0, sizeof(struct epoll_event));
+        event.events = EPOLLIN;
+        event.data.ptr = NULL;
+
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, scheduler_shard_fd(i), &event) < 0) {
+            printf("\t> Epoll: ERROR!\n");
+            exit(1);
+        }
+
+        if (pthread_create(&reactor->thread, NULL, _reactor_serve, (void *) reactor)) {
+            printf("\t> Reactor thread: ERROR!\n");
+            exit(1);
+        }
+
+        // Connections and games of the reactor stay in the cache of one core.
+        do {
+            cpu++;
+        } while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &cpus));
+
+        if (cpu < CPU_SETSIZE) {
+            CPU_ZERO(&affinity);
+            CPU_SET(cpu, &affinity);
+            pthread_setaffinity_np(reactor->thread, sizeof(cpu_set_t), &affinity);
+        }
+    }
+}
+
+/// Open a listener for each reactor on the port. The kernel spreads new connections among the listeners (SO_REUSEPORT),
+/// so each reactor accepts its own connections and no thread hands them over.
+/// \param port     The port.
+/// \return         Status code. 0 = Success, 1 = Error, no listener is left open.
+int reactor_listen(int port) {
+    int i;
+    int flag = 1;
+    int listen_socket;
+    reactor_t *reactor = NULL;
+    struct sockaddr_in local_addr;
+    struct epoll_event event;
+
+    memset(&local_addr, 0, sizeof(struct sockaddr_in));
+
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_port = htons((u_short) port);
+    local_addr.sin_addr.s_addr = INADDR_ANY;
+
+    for (i = 0; i < g_reactor_count; ++i) {
+        reactor = &g_reactor_list[i];
+
+        listen_socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_socket < 0)
+            break;
+
+        if (setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(int)) < 0
+            || setsockopt(listen_socket, SOL_SOCKET, SO_REUSEPORT, &flag, sizeof(int)) < 0
+            || bind(listen_socket, (struct sockaddr *) &local_addr, sizeof(struct sockaddr_in)) < 0
+            || listen(listen_socket, LISTEN_BACKLOG) < 0) {
+            close(listen_socket);
+            break;
+        }
+
+        // Level-triggered, so the reactor may accept a batch and leave the rest of the queue for its next round.
+        memset(&event, 0, sizeof(struct epoll_event));
+        event.events = EPOLLIN;
+        event.data.ptr = reactor;
+
+        reactor->listen_socket = listen_socket;
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, listen_socket, &event) < 0) {
+            reactor->listen_socket = -1;
+            close(listen_socket);
+            break;
+        }
+    }
+
+    if (i == g_reactor_count) {
+        printf("\t> Bind: OK!\n");
+        printf("\t> Listen: OK (%d reactors)!\n", g_reactor_count);
+        return 0;
+    }
+
+    // Close the listeners opened so far, the accept thread takes over.
+    while (i-- > 0) {
+        reactor = &g_reactor_list[i];
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, reactor->listen_socket, NULL);
+        close(reactor->listen_socket);
+        reactor->listen_socket = -1;
+    }
+
+    return 1;
+}
+
+/// Accept pending connections of the listener of the reactor, at most REACTOR_ACCEPT_BATCH of them, so a reconnect storm
+/// does not starve connections already served. The connections stay with the reactor for their whole life.
+/// \param reactor      The reactor.
+void _reactor_accept(reactor_t *reactor) {
+    int client_socket;
+    int count;
+    char *log_message = NULL;
+    char client_address[INET_ADDRSTRLEN];
+    struct sockaddr_in remote_addr;
+    socklen_t remote_addr_len;
+
+    for (count = 0; count < REACTOR_ACCEPT_BATCH; ++count) {
+        remote_addr_len = sizeof(struct sockaddr_in);
+        client_socket = accept4(reactor->listen_socket, (struct sockaddr *) &remote_addr, &remote_addr_len,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (client_socket < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // Log.
+                log_message = memory_malloc(sizeof(char) * 256, 0);
+                sprintf(log_message, "\t> ERROR during accepting a new connection (%d)!\n", errno);
+                write_log(log_message);
+                memory_free(log_message, 0);
+            }
+
+            return;
+        }
+
+        inet_ntop(AF_INET, &remote_addr.sin_addr, client_address, INET_ADDRSTRLEN);
+
+        _reactor_admit(reactor, client_socket, client_address);
+    }
+}
+
+/// Hand over a socket accepted by the accept thread to one of the reactors.
+/// \param socket           Client socket. It has to be non-blocking.
+/// \param client_address   Client address.
+/// \return                 Status code. 0 = Success, 1 = The connection is refused, the socket is closed.
+int reactor_add_connection(int socket, char *client_address) {
+    return _reactor_admit(&g_reactor_list[__sync_fetch_and_add(&r_next_reactor, 1) % g_reactor_count], socket, client_address);
+}
+
+/// Register the accepted socket as a new connection of the reactor, unless the server is at its limits.
+/// Refused sockets are closed right away, so the listen queue keeps draining.
+/// \param reactor          The reactor.
+/// \param socket           Client socket. It has to be non-blocking.
+/// \param client_address   Client address.
+/// \return                 Status code. 0 = Success, 1 = The connection is refused, the socket is closed.
+int _reactor_admit(reactor_t *reactor, int socket, char *client_address) {
+    char *log_message = NULL;
+
+    if (__atomic_load_n(&r_connection_total, __ATOMIC_RELAXED) >= r_connection_limit
+        || __atomic_load_n(&reactor->handshake_count, __ATOMIC_RELAXED) >= HANDSHAKE_LIMIT) {
+        stats_add(STATS_CONNECTIONS_REFUSED, 1);
+        close(socket);
+        return 1;
+    }
+
+    if (!_reactor_attach(reactor, socket, client_address)) {
+        // Log.
+        log_message = memory_malloc(sizeof(char) * 256, 0);
+        sprintf(log_message, "\t> ERROR during registering a new connection!\n");
+        write_log(log_message);
+        memory_free(log_message, 0);
+
+        close(socket);
+        return 1;
+    }
+
+    return 0;
+}
+
+/// Register the non-blocking socket as a new connection of the reactor.
+/// \param reactor          The reactor.
+/// \param socket           Client socket.
+/// \param client_address   Client address.
+/// \return                 The connection or NULL on failure.
+connection_t *_reactor_attach(reactor_t *reactor, int socket, char *client_address) {
+    connection_t *connection = NULL;
+    struct epoll_event event;
+
+    connection = memory_malloc(sizeof(connection_t), 0);
+    connection->socket = socket;
+    connection->state = CONNECTION_HANDSHAKE;
+    connection->protocol = PROTOCOL_TEXT;
+    snprintf(connection->client_address, sizeof(connection->client_address), "%s", client_address);
+    connection->player = NULL;
+    connection->reactor = reactor;
+    connection->timeout_unsuccessful = 0;
+    connection->prev = NULL;
+    frame_init(&connection->input);
+    pthread_mutex_init(&connection->output_mutex, NULL);
+    connection->output_head = NULL;
+    connection->output_tail = NULL;
+    connection->output_length = 0;
+    connection->is_closed = 0;
+    connection->is_broken = 0;
+    connection->reference_count = 1; // The reactor's one.
+    heartbeat_init(connection);
+    time(&connection->accepted_at);
+    connection->last_activity = connection->accepted_at;
+
+    // Register the connection in the reactor list so the idle sweep can see it.
+    pthread_mutex_lock(&reactor->mutex);
+    connection->next = reactor->connection_list;
+    if (reactor->connection_list)
+        reactor->connection_list->prev = connection;
+    reactor->connection_list = connection;
+    reactor->connection_count++;
+    pthread_mutex_unlock(&reactor->mutex);
+
+    __atomic_fetch_add(&r_connection_total, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&reactor->handshake_count, 1, __ATOMIC_RELAXED);
+
+    // Edge-triggered, the reactor drains the socket on each wake up and flushes the output once the socket is writable again.
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = connection;
+
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, socket, &event) < 0) {
+        pthread_mutex_lock(&reactor->mutex);
+        if (connection->prev)
+            connection->prev->next = connection->next;
+        else
+            reactor->connection_list = connection->next;
+        if (connection->next)
+            connection->next->prev = connection->prev;
+        reactor->connection_count--;
+        pthread_mutex_unlock(&reactor->mutex);
+
+        __atomic_fetch_sub(&r_connection_total, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&reactor->handshake_count, 1, __ATOMIC_RELAXED);
+
+        reactor_connection_release(connection);
+        return NULL;
+    }
+
+    return connection;
+}
+
+/// Take a reference of the connection, so it is not freed while it is used.
+/// \param connection   The connection.
+void reactor_connection_hold(connection_t *connection) {
+    __atomic_fetch_add(&connection->reference_count, 1, __ATOMIC_RELAXED);
+}
+
+/// Drop the reference of the connection. The last one frees it.
+/// \param connection   The connection or NULL.
+void reactor_connection_release(connection_t *connection) {
+    if (!connection || __atomic_sub_fetch(&connection->reference_count, 1, __ATOMIC_ACQ_REL) > 0)
+        return;
+
+    _reactor_output_clear(connection);
+    pthread_mutex_destroy(&connection->output_mutex);
+    memory_free(connection, 0);
+}
+
+/// Set the player of the connection. The connection holds a reference of it, any thread may change it.
+/// A closed connection does not take a player anymore, so the player and the connection do not hold each other forever.
+/// \param connection   The connection.
+/// \param player       The player or NULL.
+void reactor_connection_set_player(connection_t *connection, player_t *player) {
+    player_t *previous = NULL;
+
+    if (player)
+        player_hold(player);
+
+    pthread_mutex_lock(&connection->output_mutex);
+    if (connection->is_closed && player) {
+        previous = player;
+    } else {
+        previous = connection->player;
+        connection->player = player;
+    }
+    pthread_mutex_unlock(&connection->output_mutex);
+
+    player_release(previous);
+}
+
+/// Get the player of the connection. The player is held, it has to be released by player_release.
+/// \param connection   The connection.
+/// \return             The player or NULL.
+player_t *reactor_connection_get_player(connection_t *connection) {
+    player_t *player = NULL;
+
+    pthread_mutex_lock(&connection->output_mutex);
+    player = connection->player;
+    if (player)
+        player_hold(player);
+    pthread_mutex_unlock(&connection->output_mutex);
+
+    return player;
+}
+
+/// Queue the data to be sent to the connection. If nothing is queued yet, it is written right away and only the rest is queued.
+/// Data of a buffer are queued by a reference, other data are copied into a new buffer.
+/// A client which does not read gets disconnected, once its queue would grow over CONNECTION_OUTPUT_LIMIT.
+/// \param connection   The connection.
+/// \param data         The data.
+/// \param length       Length of the data.
+/// \param buffer       The buffer the data are part of, or NULL.
+/// \return             Status code. 0 = Success, 1 = The connection is closed or broken.
+int reactor_send(connection_t *connection, char *data, size_t length, buffer_t *buffer) {
+    output_chunk_t *chunk = NULL;
+    char *log_message = NULL;
+    ssize_t written = 0;
+    int status = 0;
+    int is_overflowed = 0;
+
+    pthread_mutex_lock(&connection->output_mutex);
+
+    if (connection->is_closed || connection->is_broken) {
+        pthread_mutex_unlock(&connection->output_mutex);
+        return 1;
+    }
+
+    // Keep the order, queued data goes first.
+    if (!connection->output_head) {
+        written = send(connection->socket, data, length, MSG_NOSIGNAL);
+
+        if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            _reactor_output_break(connection);
+            status = 1;
+        }
+
+        if (written < 0)
+            written = 0;
+    }
+
+    if (status == 0 && (size_t) written < length) {
+        if (connection->output_length + length - (size_t) written > CONNECTION_OUTPUT_LIMIT) {
+            _reactor_output_break(connection);
+            status = 1;
+            is_overflowed = 1;
+
+        } else {
+            chunk = memory_malloc(sizeof(output_chunk_t), 0);
+            chunk->next = NULL;
+            chunk->length = length - (size_t) written;
+
+            if (buffer) {
+                buffer_hold(buffer);
+                chunk->buffer = buffer;
+                chunk->data = data + written;
+            } else {
+                chunk->buffer = buffer_create(data + written, chunk->length);
+                chunk->data = chunk->buffer->data;
+            }
+
+            if (connection->output_tail)
+                connection->output_tail->next = chunk;
+            else
+                connection->output_head = chunk;
+            connection->output_tail = chunk;
+            connection->output_length += chunk->length;
+        }
+    }
+
+    pthread_mutex_unlock(&connection->output_mutex);
+
+    if (is_overflowed) {
+        // Log.
+        log_message = memory_malloc(sizeof(char) * 256, 0);
+        sprintf(log_message, "\t> Client %s does not read, its connection is closed!\n", connection->client_address);
+        write_log(log_message);
+        memory_free(log_message, 0);
+    }
+
+    return status;
+}
+
+/// Write the queued data until the queue is empty or the socket is full. Call it with the output mutex.
+/// \param connection   The connection.
+/// \return             Status code. 0 = Success, 1 = Error.
+int _reactor_flush(connection_t *connection) {
+    struct iovec iov[CONNECTION_IOV_COUNT];
+    output_chunk_t *chunk = NULL;
+    ssize_t written;
+    int iov_count;
+
+    while (connection->output_head) {
+        iov_count = 0;
+        for (chunk = connection->output_head; chunk && iov_count < CONNECTION_IOV_COUNT; chunk = chunk->next) {
+            iov[iov_count].iov_base = chunk->data;
+            iov[iov_count].iov_len = chunk->length;
+            iov_count++;
+        }
+
+        written = writev(connection->socket, iov, iov_count);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0; // The reactor gets EPOLLOUT once there is a room.
+        if (written < 0)
+            return 1;
+
+        connection->output_length -= (size_t) written;
+
+        // Drop the chunks which are sent whole, the partly sent one stays first.
+        while ((chunk = connection->output_head) && (size_t) written >= chunk->length) {
+            written -= (ssize_t) chunk->length;
+            connection->output_head = chunk->next;
+            buffer_release(chunk->buffer);
+            memory_free(chunk, 0);
+        }
+
+        if (!connection->output_head) {
+            connection->output_tail = NULL;
+        } else {
+            connection->output_head->data += written;
+            connection->output_head->length -= (size_t) written;
+        }
+    }
+
+    return 0;
+}
+
+/// Throw the queued data away and shut the connection down, the reactor then closes it as a lost one.
+/// Call it with the output mutex.
+/// \param connection   The connection.
+void _reactor_output_break(connection_t *connection) {
+    connection->is_broken = 1;
+    _reactor_output_clear(connection);
+    shutdown(connection->socket, SHUT_RDWR);
+}
+
+/// Free the queued data. Call it with the output mutex or when the connection is not shared anymore.
+/// \param connection   The connection.
+void _reactor_output_clear(connection_t *connection) {
+    output_chunk_t *chunk = NULL;
+
+    while ((chunk = connection->output_head)) {
+        connection->output_head = chunk->next;
+        buffer_release(chunk->buffer);
+        memory_free(chunk, 0);
+    }
+
+    connection->output_tail = NULL;
+    connection->output_length = 0;
+}
+
+/// The socket of the connection is writable again, flush its queue.
+/// \param connection   The connection.
+void _reactor_write(connection_t *connection) {
+    pthread_mutex_lock(&connection->output_mutex);
+
+    if (!connection->is_closed && !connection->is_broken && connection->output_head && _reactor_flush(connection))
+        _reactor_output_break(connection);
+
+    pthread_mutex_unlock(&connection->output_mutex);
+}
+
+/// Remove the connection from the reactor and close it. It is freed once nobody holds it. Only the owning reactor thread may call this.
+/// \param reactor      The reactor.
+/// \param connection   The connection.
+void _reactor_close_connection(reactor_t *reactor, connection_t *connection) {
+    if (!connection)
+        return;
+
+    epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, connection->socket, NULL);
+
+    pthread_mutex_lock(&reactor->mutex);
+    if (connection->prev)
+        connection->prev->next = connection->next;
+    else
+        reactor->connection_list = connection->next;
+    if (connection->next)
+        connection->next->prev = connection->prev;
+    reactor->connection_count--;
+    pthread_mutex_unlock(&reactor->mutex);
+
+    __atomic_fetch_sub(&r_connection_total, 1, __ATOMIC_RELAXED);
+    if (connection->state == CONNECTION_HANDSHAKE)
+        __atomic_fetch_sub(&reactor->handshake_count, 1, __ATOMIC_RELAXED);
+
+    // Senders must not touch the socket once it is closed, its number may be given to another connection.
+    pthread_mutex_lock(&connection->output_mutex);
+    connection->is_closed = 1;
+    _reactor_output_clear(connection);
+    close(connection->socket);
+    pthread_mutex_unlock(&connection->output_mutex);
+
+    heartbeat_stop(connection);
+    reactor_connection_set_player(connection, NULL);
+    reactor_connection_release(connection);
+}
+
+/// Drain the socket of the connection and process all complete messages.
+/// \param reactor      The reactor.
+/// \param connection   The connection.
+void _reactor_read(reactor_t *reactor, connection_t *connection) {
+    char scratch[RECEIVE_BUFFER_SIZE + 1];
+    char *message = NULL;
+    unsigned int length;
+    int read_size;
+    int is_handshake;
+
+    for (;;) {
+        // The message does not fit into the buffer, throw it away.
+        if (frame_is_full(&connection->input)) {
+            stats_add(STATS_MESSAGES_BAD, 1);
+            frame_init(&connection->input);
+        }
+
+        read_size = frame_recv(&connection->input, connection->socket);
+
+        if (read_size > 0) { // Successful.
+            stats_add(STATS_BYTES_RECEIVED, read_size);
+
+            time(&connection->last_activity);
+            connection->timeout_unsuccessful = 0;
+
+            // Process all complete messages, the incomplete one stays in the buffer. The handshake may switch the protocol.
+            length = 0;
+            while ((message = connection->protocol == PROTOCOL_BINARY
+                              ? frame_next_binary(&connection->input, scratch, &length)
+                              : frame_next(&connection->input, scratch, &length))) {
+                if (!length)
+                    continue;
+
+                stats_add(STATS_MESSAGES_RECEIVED, 1);
+
+                is_handshake = connection->state == CONNECTION_HANDSHAKE;
+                if (svr_receive(connection, message, length)) {
+                    _reactor_close_connection(reactor, connection);
+                    return;
+                }
+
+                // The handshake is done, the connection does not count against the handshake limit anymore.
+                if (is_handshake && connection->state != CONNECTION_HANDSHAKE)
+                    __atomic_fetch_sub(&reactor->handshake_count, 1, __ATOMIC_RELAXED);
+            }
+
+            // The binary client is out of sync, there is no way to find the next frame.
+            if (length == FRAME_INVALID) {
+                stats_add(STATS_MESSAGES_BAD, 1);
+                svr_connection_lost(connection);
+                _reactor_close_connection(reactor, connection);
+                return;
+            }
+
+        } else if (read_size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { // Socket is drained.
+            return;
+
+        } else if (read_size < 0 && errno == EINTR) {
+            continue;
+
+        } else { // 0 = closed connection, -1 = unsuccessful.
+            svr_connection_lost(connection);
+            _reactor_close_connection(reactor, connection);
+            return;
+        }
+    }
+}
+
+/// Check idle connections of the reactor. Called once per second.
+/// \param reactor      The reactor.
+/// \param now          Current time.
+void _reactor_sweep(reactor_t *reactor, time_t now) {
+    connection_t *connection = NULL;
+    connection_t *next = NULL;
+
+    pthread_mutex_lock(&reactor->mutex);
+    connection = reactor->connection_list;
+    pthread_mutex_unlock(&reactor->mutex);
+
+    // Only this thread removes connections from the list, new ones are pushed to the front.
+    while (connection) {
+        next = connection->next;
+
+        // The client connected, but did not finish the handshake in time.
+        if (connection->state == CONNECTION_HANDSHAKE && difftime(now, connection->accepted_at) >= TIMEOUT_HANDSHAKE) {
+            stats_add(STATS_HANDSHAKE_TIMEOUTS, 1);
+            _reactor_close_connection(reactor, connection);
+
+        } else if (difftime(now, connection->last_activity) >= TIMEOUT_IDLE) {
+            connection->last_activity = now;
+
+            if (svr_connection_idle(connection))
+                _reactor_close_connection(reactor, connection);
+        }
+
+        connection = next;
+    }
+
+    // Lost players are expired by the first reactor only.
+    if (reactor->index == 0)
+        player_expire_lost();
+}
+
+/// Event loop of the reactor. It serves its connections, its listener and the game events of its shard.
+/// \param arg      The reactor.
+/// \return         NULL.
+void *_reactor_serve(void *arg) {
+    reactor_t *reactor = (reactor_t *) arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    connection_t *connection = NULL;
+    time_t now;
+    int i, n;
+
+    while (__atomic_load_n(&reactor->is_running, __ATOMIC_ACQUIRE)) {
+        n = epoll_wait(reactor->epoll_fd, events, REACTOR_MAX_EVENTS, 1000);
+
+        for (i = 0; i < n; ++i) {
+            if (!events[i].data.ptr) {
+                scheduler_run(reactor->index);
+                continue;
+            }
+
+            if (events[i].data.ptr == reactor) {
+                _reactor_accept(reactor);
+                continue;
+            }
+
+            connection = (connection_t *) events[i].data.ptr;
+
+            // Write first, reading may close the connection.
+            if (events[i].events & EPOLLOUT)
+                _reactor_write(connection);
+
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                _reactor_read(reactor, connection);
+        }
+
+        time(&now);
+        if (now != reactor->last_sweep) {
+            reactor->last_sweep = now;
+            _reactor_sweep(reactor, now);
+        }
+    }
+
+    // Players keep their connections until they are freed, senders see them closed.
+    while (reactor->connection_list)
+        _reactor_close_connection(reactor, reactor->connection_list);
+
+    if (reactor->listen_socket >= 0)
+        close(reactor->listen_socket);
+
+    return NULL;
+}
+
+/// Stop reactor threads. Each one finishes its round and closes its connections.
+void reactor_free() {
+    int i;
+
+    for (i = 0; i < g_reactor_count; ++i) {
+        __atomic_store_n(&g_reactor_list[i].is_running, 0, __ATOMIC_RELEASE);
+        scheduler_wake(i);
+    }
+
+    for (i = 0; i < g_reactor_count; ++i) {
+        pthread_join(g_reactor_list[i].thread, NULL);
+        close(g_reactor_list[i].epoll_fd);
+        pthread_mutex_destroy(&g_reactor_list[i].mutex);
+    }
+}
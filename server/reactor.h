@@ -0,0 +1,33 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_REACTOR_H
+#define SERVER_REACTOR_H
+
+extern reactor_t g_reactor_list[REACTOR_THREAD_COUNT];
+extern int g_reactor_count;
+
+int reactor_count();
+void reactor_init();
+int reactor_listen(int port);
+void _reactor_accept(reactor_t *reactor);
+int reactor_add_connection(int socket, char *client_address);
+int _reactor_admit(reactor_t *reactor, int socket, char *client_address);
+connection_t *_reactor_attach(reactor_t *reactor, int socket, char *client_address);
+void reactor_connection_hold(connection_t *connection);
+void reactor_connection_release(connection_t *connection);
+void reactor_connection_set_player(connection_t *connection, player_t *player);
+player_t *reactor_connection_get_player(connection_t *connection);
+int reactor_send(connection_t *connection, char *data, size_t length, buffer_t *buffer);
+int _reactor_flush(connection_t *connection);
+void _reactor_output_break(connection_t *connection);
+void _reactor_output_clear(connection_t *connection);
+void _reactor_write(connection_t *connection);
+void _reactor_close_connection(reactor_t *reactor, connection_t *connection);
+void _reactor_read(reactor_t *reactor, connection_t *connection);
+void _reactor_sweep(reactor_t *reactor, time_t now);
+void *_reactor_serve(void *arg);
+void reactor_free();
+
+#endif //SERVER_REACTOR_H
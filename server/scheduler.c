@@ -0,0 +1,236 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include "constants.h"
+#include "structs.h"
+#include "scheduler.h"
+#include "timer.h"
+
+// Shards of strands. Each shard is served by its own reactor thread, so a strand never moves between cores.
+scheduler_shard_t c_shard_list[REACTOR_THREAD_COUNT];
+int c_shard_count = 0;
+int c_is_running = 0;
+
+/// Create the shards. Reactors serve them once their event file descriptors are signalled.
+/// \param shard_count  Number of shards, one per reactor.
+void scheduler_init(int shard_count) {
+    int i;
+    scheduler_shard_t *shard = NULL;
+
+    c_shard_count = shard_count;
+
+    for (i = 0; i < c_shard_count; ++i) {
+        shard = &c_shard_list[i];
+
+        pthread_mutex_init(&shard->mutex, NULL);
+        shard->run_list = NULL;
+        shard->run_list_tail = NULL;
+
+        shard->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (shard->event_fd < 0) {
+            printf("\t> Scheduler shard: ERROR!\n");
+            exit(1);
+        }
+    }
+
+    __atomic_store_n(&c_is_running, 1, __ATOMIC_RELEASE);
+}
+
+/// Event file descriptor of the shard. It becomes readable when the shard has strands to serve.
+/// \param shard    Index of the shard.
+/// \return         The file descriptor.
+int scheduler_shard_fd(int shard) {
+    return c_shard_list[shard].event_fd;
+}
+
+/// Initialize the strand. Tasks of the strand never run concurrently and run in the order they were posted.
+/// \param strand   The strand.
+/// \param shard    Index of the shard which runs the tasks. Out of range indexes fall back to the first shard.
+void scheduler_strand_init(strand_t *strand, int shard) {
+    pthread_mutex_init(&strand->mutex, NULL);
+    strand->head = NULL;
+    strand->tail = NULL;
+    strand->is_scheduled = 0;
+    strand->shard = shard >= 0 && shard < c_shard_count ? shard : 0;
+    strand->run_next = NULL;
+}
+
+/// Destroy the strand. It must not have pending tasks.
+/// \param strand   The strand.
+void scheduler_strand_destroy(strand_t *strand) {
+    pthread_mutex_destroy(&strand->mutex);
+}
+
+/// Wake the reactor thread of the shard up.
+/// \param shard    Index of the shard.
+void scheduler_wake(int shard) {
+    uint64_t value = 1;
+
+    if (write(c_shard_list[shard].event_fd, &value, sizeof(value)) < 0)
+        return; // The counter is already signalled.
+}
+
+/// Append the strand at the end of the run list of its shard. The shard is woken up if the list was empty.
+/// \param strand   The strand.
+void _scheduler_run_list_add(strand_t *strand) {
+    scheduler_shard_t *shard = &c_shard_list[strand->shard];
+    int was_empty;
+
+    strand->run_next = NULL;
+
+    pthread_mutex_lock(&shard->mutex);
+
+    was_empty = shard->run_list == NULL;
+    if (shard->run_list_tail)
+        shard->run_list_tail->run_next = strand;
+    else
+        shard->run_list = strand;
+    shard->run_list_tail = strand;
+
+    pthread_mutex_unlock(&shard->mutex);
+
+    if (was_empty)
+        scheduler_wake(strand->shard);
+}
+
+/// Post the task to the strand. The reactor of its shard runs it as soon as the previous tasks of the strand are done.
+/// Tasks posted once the scheduler is stopped are released without running.
+/// \param strand   The strand.
+/// \param task     The task.
+void scheduler_post(strand_t *strand, task_t *task) {
+    int is_scheduled;
+
+    if (!__atomic_load_n(&c_is_running, __ATOMIC_ACQUIRE)) {
+        task->release(task);
+        return;
+    }
+
+    task->next = NULL;
+
+    pthread_mutex_lock(&strand->mutex);
+
+    if (strand->tail)
+        strand->tail->next = task;
+    else
+        strand->head = task;
+    strand->tail = task;
+
+    // The strand is already waiting in the run list or its reactor serves it.
+    is_scheduled = strand->is_scheduled;
+    strand->is_scheduled = 1;
+
+    pthread_mutex_unlock(&strand->mutex);
+
+    if (!is_scheduled)
+        _scheduler_run_list_add(strand);
+}
+
+/// Post the task to the strand after the delay. The task waits in the timer wheel, no thread is held meanwhile.
+/// \param strand   The strand.
+/// \param task     The task.
+/// \param delay    The delay in milliseconds.
+void scheduler_post_delayed(strand_t *strand, task_t *task, long delay) {
+    task->strand = strand;
+
+    timer_entry_init(&task->timer, _scheduler_timer_expired, task);
+    timer_schedule(&task->timer, delay);
+}
+
+/// Post the delayed task whose timer expired. It runs on the timer thread.
+/// \param timer    Timer of the task.
+void _scheduler_timer_expired(timer_entry_t *timer) {
+    task_t *task = (task_t *) timer->data;
+
+    scheduler_post(task->strand, task);
+}
+
+/// Serve strands of the shard. Only the reactor thread of the shard calls it. All tasks each strand has at the moment are run at once.
+/// Strands posted to meanwhile wait for the next wake up, so connections of the reactor do not starve.
+/// Tasks are released only after the reactor stops touching the strand, since releasing may free it.
+/// \param index    Index of the shard.
+void scheduler_run(int index) {
+    scheduler_shard_t *shard = &c_shard_list[index];
+    strand_t *strand = NULL;
+    strand_t *next_strand = NULL;
+    task_t *tasks = NULL;
+    task_t *task = NULL;
+    task_t *next = NULL;
+    uint64_t value;
+
+    // Reset the event, strands added to the run list from now on signal it again.
+    if (read(shard->event_fd, &value, sizeof(value)) < 0)
+        value = 0;
+
+    pthread_mutex_lock(&shard->mutex);
+    strand = shard->run_list;
+    shard->run_list = NULL;
+    shard->run_list_tail = NULL;
+    pthread_mutex_unlock(&shard->mutex);
+
+    for (; strand; strand = next_strand) {
+        next_strand = strand->run_next;
+
+        pthread_mutex_lock(&strand->mutex);
+        tasks = strand->head;
+        strand->head = NULL;
+        strand->tail = NULL;
+        pthread_mutex_unlock(&strand->mutex);
+
+        for (task = tasks; task; task = task->next)
+            task->run(task);
+
+        pthread_mutex_lock(&strand->mutex);
+        if (strand->head) {
+            pthread_mutex_unlock(&strand->mutex);
+            _scheduler_run_list_add(strand);
+        } else {
+            strand->is_scheduled = 0;
+            pthread_mutex_unlock(&strand->mutex);
+        }
+
+        for (task = tasks; task; task = next) {
+            next = task->next;
+            task->release(task);
+        }
+    }
+}
+
+/// Stop the scheduler. Tasks which have not run yet are released without running.
+/// Stop reactors and the timer first, so nobody serves the shards and delayed tasks are posted and released here as well.
+void scheduler_free() {
+    int i;
+    scheduler_shard_t *shard = NULL;
+    strand_t *strand = NULL;
+    task_t *task = NULL;
+    task_t *next = NULL;
+
+    __atomic_store_n(&c_is_running, 0, __ATOMIC_RELEASE);
+
+    for (i = 0; i < c_shard_count; ++i) {
+        shard = &c_shard_list[i];
+
+        while ((strand = shard->run_list)) {
+            shard->run_list = strand->run_next;
+            task = strand->head;
+            strand->head = NULL;
+            strand->tail = NULL;
+            strand->is_scheduled = 0;
+
+            for (; task; task = next) {
+                next = task->next;
+                task->release(task);
+            }
+        }
+        shard->run_list_tail = NULL;
+
+        close(shard->event_fd);
+        pthread_mutex_destroy(&shard->mutex);
+    }
+}
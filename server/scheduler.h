@@ -0,0 +1,20 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_SCHEDULER_H
+#define SERVER_SCHEDULER_H
+
+void scheduler_init(int shard_count);
+int scheduler_shard_fd(int shard);
+void scheduler_strand_init(strand_t *strand, int shard);
+void scheduler_strand_destroy(strand_t *strand);
+void scheduler_wake(int shard);
+void _scheduler_run_list_add(strand_t *strand);
+void scheduler_post(strand_t *strand, task_t *task);
+void scheduler_post_delayed(strand_t *strand, task_t *task, long delay);
+void _scheduler_timer_expired(timer_entry_t *timer);
+void scheduler_run(int index);
+void scheduler_free();
+
+#endif //SERVER_SCHEDULER_H
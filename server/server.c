@@ -1,272 +1,294 @@
+#define _GNU_SOURCE // accept4.
+
 #include <stdio.h>
 #include <time.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include "constants.h"
-#include "stats.h"
 #include "structs.h"
+#include "stats.h"
+#include "logger.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "timer.h"
 #include "player.h"
 #include "colors.h"
 #include "server.h"
 #include "memory.h"
 #include "game.h"
 #include "game_logic.h"
-
-player_t *g_player_list;
-pthread_mutex_t g_player_list_mutex;
-game_t *g_game_list;
-pthread_mutex_t g_game_list_mutex;
-pthread_t thread_id;
-
-// Struct to be able to set timeout of socket.
-struct timeval timeout;
-
-/// Send the message to entered socket and write the message to statistics.
-/// \param socket                   Socket where the message is sent.
+#include "reactor.h"
+#include "table.h"
+#include "id.h"
+#include "lobby.h"
+#include "buffer.h"
+#include "token_hash.h"
+#include "parser.h"
+#include "heartbeat.h"
+#include "admin.h"
+
+table_t g_player_table;
+table_t g_player_addr_table;
+pthread_rwlock_t g_player_table_lock = PTHREAD_RWLOCK_INITIALIZER;
+table_t g_game_table;
+game_t *g_game_open_list;
+game_t *g_game_open_list_tail;
+long g_game_open_count;
+pthread_rwlock_t g_game_table_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Handlers of requests by the command. Handshake commands are not valid requests.
+request_handler_t v_handlers[TOKEN_COUNT] = {
+        [TOKEN_GET_GAMES] = _svr_handle_get_games,
+        [TOKEN_LOBBY_SUBSCRIBE] = _svr_handle_lobby_subscribe,
+        [TOKEN_CREATE_NEW_GAME] = _svr_handle_create_new_game,
+        [TOKEN_JOIN_PLAYER_TO_GAME] = _svr_handle_join_player_to_game,
+        [TOKEN_DISCONNECT_PLAYER] = _svr_handle_disconnect_player,
+        [TOKEN_DISCONNECT_PLAYER_FROM_GAME] = _svr_handle_disconnect_player_from_game,
+        [TOKEN_GAME_CHOICE_SELECTED] = _svr_handle_game_choice_selected,
+        [TOKEN_PONG] = _svr_handle_pong,
+};
+
+/// Queue the message for sending to the connection and write the message to statistics. It never blocks.
+/// \param connection               Connection where the message is sent or NULL.
 /// \param message                  The Message.
 /// \param is_broadcast_message     Tells, if it is single message or broadcast the same messages to multiple clients.
-void svr_send(int socket, char *message, int is_broadcast_message) {
+void svr_send(connection_t *connection, char *message, int is_broadcast_message) {
+    size_t length = strlen(message) * sizeof(char);
+
+    if (!connection)
+        return;
+
     if (!is_broadcast_message)
         printf(ANSI_COLOR_BLUE "--->>>\t\t\t %s" ANSI_COLOR_RESET, message);
 
-    bytes_sent += send(socket, message, strlen(message) * sizeof(char), 0);
-    messages_sent++;
+    if (!reactor_send(connection, message, length, NULL))
+        stats_sent((long) length);
 }
 
-/// Check if ID is already in list of players or game instances.
-/// \param id
-/// \return
-int _svr_find_id(char *id) {
-    if (!id)
-        return -1;
+/// Queue the buffer for sending to the connection. The buffer is shared, not copied, even if it has to wait in the queue.
+/// \param connection               Connection where the buffer is sent or NULL.
+/// \param buffer                   The buffer.
+/// \param offset                   Where the sent part of the buffer starts.
+/// \param is_broadcast_message     Tells, if it is single message or broadcast the same messages to multiple clients.
+void svr_send_buffer(connection_t *connection, buffer_t *buffer, size_t offset, int is_broadcast_message) {
+    size_t length = buffer->length - offset;
 
-    // Check players.
-    pthread_mutex_lock(&g_player_list_mutex);
+    if (!connection)
+        return;
 
-    if (g_player_list != NULL) {
-        player_t *player_ptr = g_player_list;
+    if (!is_broadcast_message)
+        printf(ANSI_COLOR_BLUE "--->>>\t\t\t %s" ANSI_COLOR_RESET, buffer->data + offset);
 
-        do {
-            if (strcmp(player_ptr->id, id) == 0) {
-                pthread_mutex_unlock(&g_player_list_mutex);
-                return 1;
-            }
+    if (!reactor_send(connection, buffer->data + offset, length, buffer))
+        stats_sent((long) length);
+}
 
-            player_ptr = player_ptr->next;
-        } while (player_ptr != NULL);
+/// Send a text messsage to all players. All of them share the same buffer.
+/// \param buffer   Message to send. The reference is taken over.
+void svr_broadcast(buffer_t *buffer) {
+    if (!buffer)
+        return;
 
-    }
+    printf(ANSI_COLOR_BLUE "--->>> (BC)\t\t %s" ANSI_COLOR_RESET, buffer->data);
 
-    pthread_mutex_unlock(&g_player_list_mutex);
+    unsigned int index = 0;
+    player_t *player_ptr = NULL;
 
-    // Check games.
-    pthread_mutex_lock(&g_game_list_mutex);
+    pthread_rwlock_rdlock(&g_player_table_lock);
+    while ((player_ptr = table_iterate(&g_player_table, &index)))
+        if (player_ptr->is_disconnected != 1)
+            player_send_buffer(player_ptr, buffer, 0, 1);
+    pthread_rwlock_unlock(&g_player_table_lock);
 
-    if (g_game_list != NULL) {
-        game_t *game_ptr = g_game_list;
+    buffer_release(buffer);
+}
 
-        do {
-            if (strcmp(game_ptr->id, id) == 0) {
-                pthread_mutex_unlock(&g_game_list_mutex);
-                return 1;
-            }
+/// Process a complete message received on the connection. The first message of the connection is handled as the handshake.
+/// \param connection   The connection.
+/// \param message      The message.
+/// \param length       Length of the message.
+/// \return             Status code. 0 = Success, 1 = The connection should be closed.
+int svr_receive(connection_t *connection, char *message, unsigned int length) {
+    int status = 0;
+    request_t request;
+    player_t *player_ptr = NULL;
 
-            game_ptr = game_ptr->next;
-        } while (game_ptr != NULL);
-    }
+    stats_request_begin();
 
-    pthread_mutex_unlock(&g_game_list_mutex);
+    if (connection->protocol == PROTOCOL_BINARY) {
+        // The command is told by the opcode, the fields are decoded to the tokens of the text message.
+        printf(ANSI_COLOR_CYAN "<<<--- (BIN)\t\t %u B\n" ANSI_COLOR_RESET, length);
+        parser_decode(message, length, &request);
 
-    return 0;
-}
+    } else {
+        printf(ANSI_COLOR_CYAN "<<<---\t\t\t %s\n" ANSI_COLOR_RESET, message);
 
-/// Generates unique ID for players and game instances.
-/// \return
-char *svr_generate_id() {
-    char *id = memory_malloc(sizeof(char) * (19 + 1), 0);
+        // Tokens are slices of the receive buffer, nothing is copied.
+        parser_split(message, length, &request);
+    }
 
-    do {
-        sprintf(id, "%d", rand());
-    } while (_svr_find_id(id) != 0);
+    if (connection->state == CONNECTION_HANDSHAKE) {
+        status = _svr_process_handshake(connection, &request);
 
-    return id;
+    } else if (!(player_ptr = reactor_connection_get_player(connection))) {
+        // The player was removed meanwhile, the connection is going to be closed.
+        status = 1;
 
-}
-
-/// Send a text messsage to all players.
-/// \param message  Message to send.
-void svr_broadcast(char *message) {
-    if (!message)
-        return;
+    } else {
+        player_set_disconnected(player_ptr, 0);
+        _svr_process_request(&request);
+        player_release(player_ptr);
+    }
 
-    printf(ANSI_COLOR_BLUE "--->>> (BC)\t\t %s" ANSI_COLOR_RESET, message);
+    stats_request_end();
 
-    pthread_mutex_lock(&g_player_list_mutex);
-    if (g_player_list != NULL) {
-        player_t *player_ptr = g_player_list;
+    return status;
+}
 
-        do {
-            if (player_ptr->is_disconnected != 1)
-                svr_send(player_ptr->socket, message, 1);
+/// The connection is closed or broken. Keep the player for a while to be able to reconnect.
+/// A peer evicted by the heartbeat is known to be dead, its seat is given up after a much shorter grace.
+/// \param connection   The connection.
+void svr_connection_lost(connection_t *connection) {
+    player_t *player_ptr = reactor_connection_get_player(connection);
 
-            player_ptr = player_ptr->next;
-        } while (player_ptr != NULL);
+    if (!player_ptr)
+        return;
 
+    // The player may have reconnected by another connection meanwhile.
+    if (!player_detach_connection(player_ptr, connection)) {
+        player_set_lost(player_ptr, heartbeat_is_evicted(connection) ? TIMEOUT_LOST_HEARTBEAT : TIMEOUT_LOST_CONN);
+        player_set_disconnected(player_ptr, 1); // Means, do not bother with updating client. Client is already closed or do not have connection.
     }
-    pthread_mutex_unlock(&g_player_list_mutex);
 
-    memory_free(message, 0);
+    reactor_connection_set_player(connection, NULL);
+    player_release(player_ptr);
 }
 
-/// The main data stream to each player.
-/// \param arg      Pointer to newly added player.
-/// \return         Status code.
-void *_svr_serve_receiving(void *arg) {
-    player_t *player_ptr = (player_t *) arg;
-    int client_sock = player_ptr->socket;
-    char *id = player_ptr->id;
-    int read_size;
-    int timeout_lost_conn = 0;
-    int timeout_unsuccessful = 0;
-    char cbuf[1024];
+/// Nothing was received on the connection for TIMEOUT_IDLE seconds.
+/// \param connection   The connection.
+/// \return             Status code. 0 = Keep the connection, 1 = The connection should be closed.
+int svr_connection_idle(connection_t *connection) {
+    player_t *player_ptr = NULL;
     char *message = NULL;
 
-    while (timeout_lost_conn <= TIMEOUT_LOST_CONN) {
-        if ((read_size = (int) recv(client_sock, cbuf, 1024 * sizeof(char), 0)) != 0) { // 0 = closed connection, -1 = unsuccessful, >0 = length of the received message.
-            if (read_size == -1) { // Unsuccessful (some error occurred).
-                player_ptr->is_disconnected = 1;
+    // Client did not finish the handshake in time.
+    if (connection->state == CONNECTION_HANDSHAKE || !(player_ptr = reactor_connection_get_player(connection)))
+        return 1;
 
-                timeout_unsuccessful++;
+    player_set_disconnected(player_ptr, 1);
+    connection->timeout_unsuccessful++;
 
-                if (timeout_unsuccessful > TIMEOUT_UNSUCCESSFUL) {
-                    // Send a message back to client.
-                    message = memory_malloc(sizeof(char) * 256, 0);
-                    sprintf(message, "%s;kick_player\n", player_ptr->id); // Token message.
-                    svr_send(player_ptr->socket, message, 0);
-                    memory_free(message, 0);
-
-                    break;
-                }
-
-            } else { // Successful.
-                player_ptr->is_disconnected = 0;
-                bytes_received += read_size;
-                messages_received++;
-
-                printf(ANSI_COLOR_CYAN "<<<---\t\t\t %s" ANSI_COLOR_RESET, cbuf);
-                _svr_process_request(cbuf);
-                memset(cbuf, 0, 1024 * sizeof(char));
-
-                timeout_unsuccessful = 0;
-            }
-
-        } else { // Lost Connection.
-            if (!player_ptr->socket) // If the player has no communication anymore. The player has disconnected correctly.
-                break;
-
-            timeout_lost_conn++;
-            player_ptr->is_disconnected = 1;
-
-            sleep(1);
-
-            if (player_ptr->socket) // Update socket.
-                client_sock = player_ptr->socket;
-        }
+    if (connection->timeout_unsuccessful <= TIMEOUT_UNSUCCESSFUL) {
+        player_release(player_ptr);
+        return 0;
     }
 
-    // If the connection is lost.
-    player_ptr = player_find(id);
-    if (player_ptr) {
-        player_ptr->is_disconnected = 1; // Means, do not bother with updating client. Client is already closed or do not have connection.
+    // Send a message back to client.
+    message = memory_malloc(sizeof(char) * 256, 0);
+    sprintf(message, "%s;kick_player\n", player_ptr->id); // Token message.
+    svr_send(connection, message, 0);
+    memory_free(message, 0);
 
-        if (player_ptr->game) {
-            player_disconnect_from_game(player_ptr, player_ptr->game);
-        }
+    reactor_connection_set_player(connection, NULL);
+    player_set_connection(player_ptr, NULL);
 
-        player_remove(player_ptr);
-    }
+    player_remove(player_ptr);
+    player_release(player_ptr);
 
-    return 0;
+    return 1;
 }
 
 /// Obtaining data from client about player creation. Create a player.
-/// \param arg      Client socket.
-/// \return         NULL.
-void *_svr_connection_handler(void *arg) {
-    char msg[64];
+/// \param connection   The connection.
+/// \param request      The first message of the connection.
+/// \return             Status code. 0 = Success, 1 = Error.
+int _svr_process_handshake(connection_t *connection, request_t *request) {
     char *id = NULL;
     char *tokens = NULL;
+    token_t token = TOKEN_COUNT;
     player_t *player = NULL;
     char *log_message = NULL;
     char *nickname = NULL;
     char *message = NULL;
+    char *option = "";
+    protocol_t protocol = PROTOCOL_TEXT;
     int is_reconnecting = 0; // Check if user is connecting first time or he is reconnecting.
+    int i;
 
-    // Fill the msg var with zeros.
-    memset(msg, 0, strlen(msg));
-
-    // Count stats.
-    bytes_received += recv(((remote_connection_t *) arg)->client_socket, msg, sizeof(char) * 64, 0);
-    messages_received++;
+    // Expecting message like "1;_player_nickname;John;" or "1;_player_nickname;John;binary;".
+    if (request->count > 0) {
+        id = request->tokens[0].data;
 
-    // Set socket params (receive timeout).
-    setsockopt(((remote_connection_t *) arg)->client_socket, SOL_SOCKET, SO_RCVTIMEO, (char *) &timeout, sizeof(timeout));
-
-    id = strtok(msg, ";"); // Expecting message like "1;nickname;John;".
-    if (id) {
-        tokens = strtok(NULL, ";");
+        if (request->count > 1) {
+            tokens = request->tokens[1].data;
+            token = (token_t) request->command;
+            if (token != TOKEN_COUNT)
+                stats_request_command((stats_command_t) (STATS_COMMAND_PLAYER_NICKNAME + token));
+        }
     } else {
-        messages_bad++;
+        stats_add(STATS_MESSAGES_BAD, 1);
     }
 
     // Client is trying to reconnect.
     if (
-            (tokens != NULL && strcmp(tokens, "_player_reconnect") == 0)
-            || (tokens != NULL && (player = player_find_unknown_reconnect(((remote_connection_t *) arg)->client_address)))
+            (tokens != NULL && token == TOKEN_PLAYER_RECONNECT)
+            || (tokens != NULL && (player = player_find_unknown_reconnect(connection->client_address)))
             ) { // Client is trying to reconnect.
         is_reconnecting = 1;
 
         if (!player)
             player = player_find(id);
         if (player)
-            player_change_socket(player, ((remote_connection_t *) arg)->client_socket);
+            player_change_socket(player, connection);
 
     } else {
         player = NULL;
     }
 
+    // Options follow the nickname on both paths, "id;_player_reconnect;nickname;options", so a nickname is never read as an option.
+    for (i = 3; i < request->count; ++i) {
+        if (strcmp(request->tokens[i].data, PROTOCOL_BINARY_OPTION) == 0) {
+            protocol = PROTOCOL_BINARY;
+            option = ";" PROTOCOL_BINARY_OPTION;
+        }
+    }
+
     // Client is trying to connect to server...
     if (tokens != NULL && is_reconnecting && player != NULL) { // Client is trying to reconnect.
-        player->is_disconnected = 0; // Reset, client is back.
+        player_set_disconnected(player, 0); // Reset, client is back.
 
         // Send a message back to client.
         message = memory_malloc(sizeof(char) * 256, 0);
-        sprintf(message, "%s;_player_id_reconnected\n", player->id); // Token message.
-        svr_send(player->socket, message, 0);
+        sprintf(message, "%s;_player_id_reconnected%s\n", player->id, option); // Token message.
+        player_send(player, message, 0);
         memory_free(message, 0);
 
-    } else if ((tokens != NULL && is_reconnecting) || (tokens != NULL && strcmp(tokens, "_player_nickname") == 0)) { // Client is firstly connecting to the server.
+        // The player table keeps the player, the reference taken by the search is not needed anymore.
+        player_release(player);
+
+    } else if ((tokens != NULL && is_reconnecting) || (tokens != NULL && token == TOKEN_PLAYER_NICKNAME)) { // Client is firstly connecting to the server.
         is_reconnecting = 0;
 
-        nickname = strtok(NULL, ";");
+        nickname = request->count > 2 ? request->tokens[2].data : NULL;
 
         if (!nickname) {
-            sprintf(nickname, "Player"); // Default player name.
+            nickname = "Player"; // Default player name.
         }
 
         // Create player.
-        player = player_create((remote_connection_t *) arg, nickname);
+        player = player_create(connection, nickname);
 
         // Send a message back to client.
         message = memory_malloc(sizeof(char) * 256, 0);
-        sprintf(message, "%s;_player_id\n", player->id); // Token message.
-        svr_send(player->socket, message, 0);
+        sprintf(message, "%s;_player_id%s\n", player->id, option); // Token message.
+        player_send(player, message, 0);
         memory_free(message, 0);
 
         // Add player to the list.
@@ -279,44 +301,18 @@ void *_svr_connection_handler(void *arg) {
         write_log(log_message);
         memory_free(log_message, 0);
 
-        messages_bad++;
-
-        // Free.
-        memory_free(((remote_connection_t *) arg)->client_address, 0);
-        memory_free(arg, 0);
-
-        close(((remote_connection_t *) arg)->client_socket);
+        // The player found for a reconnect may have been removed meanwhile.
+        player_release(player);
+        stats_add(STATS_MESSAGES_BAD, 1);
 
-        return NULL;
+        return 1;
     }
 
-    // Create a new thread to solve player data sending separately.
-    thread_id = 0;
-    if (pthread_create(&thread_id, NULL, _svr_serve_receiving, (void *) player)) {
-        // Unsuccessful thread start branch.
-        // Log.
-        log_message = memory_malloc(sizeof(char) * 256, 0);
-        sprintf(log_message, "\t> Fatal ERROR during creating a new thread!\n");
-        write_log(log_message);
-        memory_free(log_message, 0);
-
-        // Send a message back to client.
-        message = memory_malloc(sizeof(char) * 256, 0);
-        sprintf(message, "%s;player_crash\n", player->id); // Token message.
-        svr_send(player->socket, message, 0);
-        memory_free(message, 0);
-
-        // Remove player because of unsuccessful thread start.
-        player_remove(player);
-
-        // Free.
-        memory_free(((remote_connection_t *) arg)->client_address, 0);
-        memory_free(arg, 0);
-
-        close(((remote_connection_t *) arg)->client_socket);
+    // Frames after the handshake are read by the chosen protocol. Messages to the client stay text.
+    connection->state = CONNECTION_ACTIVE;
+    connection->protocol = protocol;
 
-        return NULL;
-    }
+    heartbeat_start(connection);
 
     // Log.
     log_message = memory_malloc(sizeof(char) * 256, 0);
@@ -327,11 +323,7 @@ void *_svr_connection_handler(void *arg) {
     write_log(log_message);
     memory_free(log_message, 0);
 
-    // Free.
-    memory_free(((remote_connection_t *) arg)->client_address, 0);
-    memory_free(arg, 0);
-
-    return NULL;
+    return 0;
 }
 
 /// Create a new socket. Listening to client connection.
@@ -343,17 +335,13 @@ void *_svr_serve_connection(void *arg) {
     int port = *(int *) arg;
     int flag = 1;
     char *log_message = NULL;
+    char client_address[INET_ADDRSTRLEN];
     struct sockaddr_in local_addr;
     struct sockaddr_in remote_addr;
     socklen_t remote_addr_len;
-    remote_connection_t *arguments = NULL;
-
-    // Set timeout to 60sec.
-    timeout.tv_sec = 60;
-    timeout.tv_usec = 0;
 
     // Create a new server socket.
-    server_socket = socket(AF_INET, SOCK_STREAM, 0);
+    server_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (server_socket <= 0)
         return NULL;
 
@@ -377,7 +365,7 @@ void *_svr_serve_connection(void *arg) {
     }
 
     // Allow to listen on the socket.
-    return_value = listen(server_socket, 5); // 5 recommended.
+    return_value = listen(server_socket, LISTEN_BACKLOG);
     if (return_value == 0) {
         printf("\t> Listen: OK!\n");
     } else {
@@ -387,28 +375,30 @@ void *_svr_serve_connection(void *arg) {
 
     for (;;) {
         // Block the process until a client connect to the server.
-        // Returns a new file descriptor, and all communication on this connection should be done using the new file descriptor.
-        client_socket = accept(server_socket, (struct sockaddr *) &remote_addr, &remote_addr_len);
-
-        if (client_socket > 0) {
-            // Create struct with arguments to be able to pass more than 1 parameter to connection handler.
-            arguments = memory_malloc(sizeof(remote_connection_t), 0);
-            arguments->client_address = memory_malloc(sizeof(char) * ((remote_connection_t *) arg)->client_address_len + 4, 0);
-            inet_ntop(AF_INET, &remote_addr.sin_addr, arguments->client_address, remote_addr_len);
-            arguments->client_address_len = remote_addr_len + 4;
-            arguments->client_socket = client_socket;
-
-            if (pthread_create(&thread_id, NULL, (void *) &_svr_connection_handler, (void *) arguments)) {
-                // Log.
-                log_message = memory_malloc(sizeof(char) * 256, 0);
-                sprintf(log_message, "\t> Fatal ERROR during creating a new thread!\n");
-                write_log(log_message);
-
-                memory_free(log_message, 0);
-                memory_free(arguments, 0);
-
-                close(client_socket);
-            }
+        // The new socket is non-blocking already, as the reactors need it.
+        remote_addr_len = sizeof(struct sockaddr_in);
+        client_socket = accept4(server_socket, (struct sockaddr *) &remote_addr, &remote_addr_len,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (client_socket >= 0) {
+            inet_ntop(AF_INET, &remote_addr.sin_addr, client_address, INET_ADDRSTRLEN);
+
+            // Hand the socket over to a reactor which serves the handshake and all further requests.
+            // Sockets over the limits are closed by it.
+            reactor_add_connection(client_socket, client_address);
+
+        } else if (errno == EINTR || errno == ECONNABORTED) {
+            continue;
+
+        } else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+            // Out of resources for a while, the queued connections wait in the backlog.
+            log_message = memory_malloc(sizeof(char) * 256, 0);
+            sprintf(log_message, "\t> ERROR during accepting a new connection (%d)!\n", errno);
+            write_log(log_message);
+            memory_free(log_message, 0);
+
+            usleep(100000);
+
         } else {
             // Log.
             log_message = memory_malloc(sizeof(char) * 256, 0);
@@ -423,125 +413,196 @@ void *_svr_serve_connection(void *arg) {
     }
 }
 
-/// Process received message from a client.
-/// \param message      The message.
-void _svr_process_request(char *message) {
-    if (!message)
+/// Process received message from a client. The command is dispatched to its handler by the table.
+/// \param request      The message split to tokens.
+void _svr_process_request(request_t *request) {
+    player_t *player = NULL;
+    token_t token = (token_t) request->command;
+
+    if (request->count < 2) {
+        _svr_count_bad_message(request);
         return;
+    }
 
-    char **tokens = _svr_split_message(message);
-    char *id;
-    player_t *player = NULL;
+    player = player_find(request->tokens[0].data);
+    if (!player) {
+        _svr_count_bad_message(request);
+        return;
+    }
+
+    // Token list which is acceptable from client side.
+    if (token == TOKEN_COUNT) {
+        _svr_count_bad_message(request);
+        player_release(player);
+        return;
+    }
+
+    stats_request_command((stats_command_t) (STATS_COMMAND_PLAYER_NICKNAME + token));
+
+    if (!v_handlers[token] || v_handlers[token](player, request))
+        _svr_count_bad_message(request);
+
+    player_release(player);
+}
+
+/// Send the list of open games to the player.
+/// \param player       The player.
+/// \param request      The request.
+/// \return             Status code. 0 = Success, 1 = Bad message.
+int _svr_handle_get_games(player_t *player, request_t *request) {
+    lobby_sync(player);
+
+    return 0;
+}
+
+/// Switch the player to delta updates of the lobby.
+/// \param player       The player.
+/// \param request      The request, optionally with the last version the client knows.
+/// \return             Status code. 0 = Success, 1 = Bad message.
+int _svr_handle_lobby_subscribe(player_t *player, request_t *request) {
+    lobby_subscribe_delta(player, request->count > 2 ? atol(request->tokens[2].data) : LOBBY_VERSION_NONE);
+
+    return 0;
+}
+
+/// Create a new game.
+/// \param player       The player.
+/// \param request      The request with the goal.
+/// \return             Status code. 0 = Success, 1 = Bad message.
+int _svr_handle_create_new_game(player_t *player, request_t *request) {
     game_t *game = NULL;
 
-    if (tokens[0]) {
-        id = tokens[0];
-        player = player_find(id);
+    if (request->count < 3)
+        return 1;
 
-        if (!player) {
-            _svr_count_bad_message(message);
-            return;
-        }
+    // A player who is still in a game returns to it, as if it joined.
+    game = player_get_game(player);
+    if (game)
+        player_join_game(player, game);
+    else
+        game_create(player, atoi(request->tokens[2].data));
+    game_release(game);
 
-        game = player->game;
+    return 0;
+}
 
-    } else {
-        _svr_count_bad_message(message);
-    }
+/// Join the player to the game.
+/// \param player       The player.
+/// \param request      The request with the game ID.
+/// \return             Status code. 0 = Success, 1 = Bad message.
+int _svr_handle_join_player_to_game(player_t *player, request_t *request) {
+    game_t *game = NULL;
 
-    // Token list which is acceptable from client side.
-    // List of events which server accepts from client side.
-    if (tokens[1]) {
-        if (strcmp(tokens[1], "get_games") == 0) {
-            game_broadcast_update_games();
-
-        } else if (strcmp(tokens[1], "create_new_game") == 0 && tokens[2]) {
-            game_create(player, atoi(tokens[2]));
-
-        } else if (strcmp(tokens[1], "join_player_to_game") == 0 && tokens[2]) {
-            if (player_connect_to_game(player, player->game ? player->game : game_find(tokens[2]))) {
-                // If player cannot join the game.
-                char *msg = NULL;
-                msg = memory_malloc(sizeof(char) * 256, 0);
-                sprintf(msg, "%s;cannot_join_game\n", player->id); // Token message.
-                svr_send(player->socket, msg, 0);
-                memory_free(msg, 0);
-            }
-
-        } else if (strcmp(tokens[1], "disconnect_player") == 0) {
-            if (player) {
-                if (player->game)
-                    player_disconnect_from_game(player, player->game);
-                player_remove(player);
-            }
-
-        } else if (strcmp(tokens[1], "disconnect_player_from_game") == 0 && tokens[2]) {
-            player_disconnect_from_game(player, game_find(tokens[2]));
-
-        } else if (strcmp(tokens[1], "game_choice_selected") == 0 && tokens[2]) {
-            game_logic_record_turn(player, atoi(tokens[2]));
+    if (request->count < 3)
+        return 1;
 
-        } else {
-            _svr_count_bad_message(message);
-        }
+    game = player_get_game(player);
+    if (!game)
+        game = game_find(request->tokens[2].data);
 
-    } else {
-        _svr_count_bad_message(message);
-    }
+    // The game may run on another shard, it answers by itself once it handles the join.
+    if (player_join_game(player, game))
+        game_refuse_player(player); // If player cannot join the game.
+    game_release(game);
 
-    memory_free(tokens, 0);
+    return 0;
 }
 
-/// Split a message to tokens.
-/// \param message      The message.
-/// \return             Split message / tokens.
-char **_svr_split_message(char *message) {
-    if (!message)
-        return NULL;
+/// Remove the player.
+/// \param player       The player.
+/// \param request      The request.
+/// \return             Status code. 0 = Success, 1 = Bad message.
+int _svr_handle_disconnect_player(player_t *player, request_t *request) {
+    player_remove(player);
+
+    return 0;
+}
 
-    char **message_split = memory_malloc(MAX_CLIENT_TOKENS * sizeof(char *), 0);
-    int i = 0;
+/// Take the player out of the game.
+/// \param player       The player.
+/// \param request      The request with the game ID.
+/// \return             Status code. 0 = Success, 1 = Bad message.
+int _svr_handle_disconnect_player_from_game(player_t *player, request_t *request) {
+    game_t *game = NULL;
 
-    message_split[i] = strtok(message, ";");
+    if (request->count < 3)
+        return 1;
 
-    if (message_split[i] == NULL)
-        return message_split;
+    game = game_find(request->tokens[2].data);
+    player_leave_game(player, game);
+    game_release(game);
 
-    i++;
-    while (i < MAX_CLIENT_TOKENS) {
-        message_split[i] = strtok(NULL, ";");
+    return 0;
+}
 
-        if (message_split[i] == NULL)
-            return message_split;
+/// Record the choice of the player.
+/// \param player       The player.
+/// \param request      The request with the choice.
+/// \return             Status code. 0 = Success, 1 = Bad message.
+int _svr_handle_game_choice_selected(player_t *player, request_t *request) {
+    if (request->count < 3)
+        return 1;
 
-        i++;
-    }
+    game_logic_record_turn(player, atoi(request->tokens[2].data));
 
-    return message_split;
+    return 0;
+}
+
+/// The client answered the ping of its connection.
+/// \param player       The player.
+/// \param request      The request with the sequence number of the ping.
+/// \return             Status code. 0 = Success, 1 = Bad message.
+int _svr_handle_pong(player_t *player, request_t *request) {
+    connection_t *connection = NULL;
+
+    if (request->count < 3)
+        return 1;
+
+    // A pong of an older ping is not an error, the peer is only slow.
+    connection = player_get_connection(player);
+    if (connection)
+        heartbeat_pong(connection, strtoul(request->tokens[2].data, NULL, 10));
+    reactor_connection_release(connection);
+
+    return 0;
 }
 
 /// Call this if incorrect message received.
-/// \param message      The message.
-void _svr_count_bad_message(char *message) {
-    printf("\t> Ignored message: \"%s\".\n", message);
-    messages_bad++;
+/// \param request      The message split to tokens.
+void _svr_count_bad_message(request_t *request) {
+    int i;
+
+    printf("\t> Ignored message: \"");
+    for (i = 0; i < request->count; ++i)
+        printf("%s%.*s", i ? ";" : "", (int) request->tokens[i].length, request->tokens[i].data);
+    printf("\".\n");
+
+    stats_add(STATS_MESSAGES_BAD, 1);
 }
 
+// The benchmarks link the server without its main.
+#ifndef SERVER_NO_MAIN
 /// The main method of the application. It creates a server with entered port number. If the port number is not submited the server will be create with the port number 10000.
+/// The optional second argument is a local port where metrics are served for scraping.
+/// The optional third argument is a path of the Unix domain socket where admin commands are answered by JSON dumps.
 /// \param argv -
 /// \param args -
 /// \return Status code of success.
 int main(int argv, char *args[]) {
     int port;
+    int metrics_port;
     char *log_message = NULL;
     char input[1024];
+    pthread_t thread_id;
     time(&time_initial);
 
+    logger_init();
+    id_init();
     colors_init();
-
-    // Initialize log file.
-    FILE *logs = fopen("server.log", "w");
-    fclose(logs);
+    player_init();
+    game_init();
+    timer_init();
+    scheduler_init(reactor_count());
 
     // Log.
     log_message = memory_malloc(sizeof(char) * 256, 0);
@@ -570,8 +631,35 @@ int main(int argv, char *args[]) {
     write_log(log_message);
     memory_free(log_message, 0);
 
+    reactor_init();
+
+    // Optional local listener for metrics scrapes.
+    if (argv > 2) {
+        metrics_port = atoi(args[2]);
+
+        log_message = memory_malloc(sizeof(char) * 256, 0);
+        if (metrics_port >= CUSTOM_PORT_LOWEST_POSSIBLE && metrics_port <= CUSTOM_PORT_HIGHEST_POSSIBLE && !metrics_init(metrics_port))
+            sprintf(log_message, "\t> Metrics are served on the local port: %d.\n", metrics_port);
+        else
+            sprintf(log_message, "\t> ERROR during starting the metrics listener!\n");
+        write_log(log_message);
+        memory_free(log_message, 0);
+    }
+
+    // Optional local socket for admin commands.
+    if (argv > 3) {
+        log_message = memory_malloc(sizeof(char) * 256, 0);
+        if (!admin_init(args[3]))
+            snprintf(log_message, 256, "\t> Admin commands are answered on the socket: %s.\n", args[3]);
+        else
+            sprintf(log_message, "\t> ERROR during starting the admin listener!\n");
+        write_log(log_message);
+        memory_free(log_message, 0);
+    }
+
+    // Each reactor accepts on its own listener, the accept thread is the fallback if the listeners cannot be opened.
     thread_id = 0;
-    if (pthread_create(&thread_id, NULL, _svr_serve_connection, (void *) &port) != 0) {
+    if ((!REACTOR_LISTENERS || reactor_listen(port)) && pthread_create(&thread_id, NULL, _svr_serve_connection, (void *) &port) != 0) {
         // Log.
         log_message = memory_malloc(sizeof(char) * 256, 0);
         sprintf(log_message, "\t> Fatal ERROR during creating a new thread!\n");
@@ -592,21 +680,32 @@ int main(int argv, char *args[]) {
             player_print();
     }
 
-    pthread_cancel(thread_id);
+    if (thread_id)
+        pthread_cancel(thread_id);
+    metrics_free();
+    admin_free();
+    reactor_free();
 
-    colors_free();
+    // Nobody runs game events anymore. The timer posts the delayed ones and the scheduler releases them, players then leave their games right away.
+    timer_free();
+    scheduler_free();
     player_free();
     game_free();
+    colors_free();
 
     log_message = memory_malloc(sizeof(char) * 256, 0);
     sprintf(log_message, "\t> Server is shutting down.\n");
     write_log(log_message);
     memory_free(log_message, 0);
 
+    logger_free();
+
     write_stats();
     memory_print_status();
 
     print_info(stdout);
 
     return 0;
-}
\ No newline at end of file
+}
+
+#endif // SERVER_NO_MAIN
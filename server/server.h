@@ -5,20 +5,32 @@
 #ifndef SERVER_MAIN_H
 #define SERVER_MAIN_H
 
-extern player_t *g_player_list;
-extern pthread_mutex_t g_player_list_mutex;
-extern game_t *g_game_list;
-extern pthread_mutex_t g_game_list_mutex;
+extern table_t g_player_table;
+extern table_t g_player_addr_table;
+extern pthread_rwlock_t g_player_table_lock;
+extern table_t g_game_table;
+extern game_t *g_game_open_list;
+extern game_t *g_game_open_list_tail;
+extern long g_game_open_count;
+extern pthread_rwlock_t g_game_table_lock;
 
-void svr_send(int socket, char *message, int is_broadcast_message);
-int _svr_find_id(char *id);
-char *svr_generate_id();
-void svr_broadcast(char *message);
-void *_svr_serve_receiving(void *arg);
-void *_svr_connection_handler(void *arg);
+void svr_send(connection_t *connection, char *message, int is_broadcast_message);
+void svr_send_buffer(connection_t *connection, buffer_t *buffer, size_t offset, int is_broadcast_message);
+void svr_broadcast(buffer_t *buffer);
+int svr_receive(connection_t *connection, char *message, unsigned int length);
+void svr_connection_lost(connection_t *connection);
+int svr_connection_idle(connection_t *connection);
+int _svr_process_handshake(connection_t *connection, request_t *request);
 void *_svr_serve_connection(void *arg);
-void _svr_process_request(char *message);
-char **_svr_split_message(char *message);
-void _svr_count_bad_message(char *message);
+void _svr_process_request(request_t *request);
+int _svr_handle_get_games(player_t *player, request_t *request);
+int _svr_handle_lobby_subscribe(player_t *player, request_t *request);
+int _svr_handle_create_new_game(player_t *player, request_t *request);
+int _svr_handle_join_player_to_game(player_t *player, request_t *request);
+int _svr_handle_disconnect_player(player_t *player, request_t *request);
+int _svr_handle_disconnect_player_from_game(player_t *player, request_t *request);
+int _svr_handle_game_choice_selected(player_t *player, request_t *request);
+int _svr_handle_pong(player_t *player, request_t *request);
+void _svr_count_bad_message(request_t *request);
 
 #endif //SERVER_MAIN_H
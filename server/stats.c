@@ -4,43 +4,348 @@
 
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 #include "constants.h"
+#include "structs.h"
 #include "stats.h"
+#include "logger.h"
 
 time_t time_initial, time_current;
-long bytes_received = 0;
-long bytes_sent = 0;
-long messages_received = 0;
-long messages_sent = 0;
-long messages_bad = 0;
+
+// Names of the commands the statistics are broken down by.
+char *s_command_names[STATS_COMMAND_COUNT] = {
+        "server",
+        "unknown",
+        "_player_nickname",
+        "_player_reconnect",
+        "get_games",
+        "lobby_subscribe",
+        "create_new_game",
+        "join_player_to_game",
+        "disconnect_player",
+        "disconnect_player_from_game",
+        "game_choice_selected",
+        "pong",
+};
+
+// Shards of all running threads and statistics of finished threads.
+stats_shard_t *s_shard_list = NULL;
+stats_shard_t s_retired;
+pthread_mutex_t s_shard_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_key_t s_shard_key;
+pthread_once_t s_shard_key_once = PTHREAD_ONCE_INIT;
+
+// Shard of the current thread and the request it is processing.
+static __thread stats_shard_t *s_shard = NULL;
+static __thread stats_command_t s_command = STATS_COMMAND_SERVER;
+static __thread struct timespec s_request_start;
+
+/// Create the thread key which retires the shard at the thread exit.
+void _stats_shard_key_create() {
+    pthread_key_create(&s_shard_key, _stats_shard_destroy);
+}
+
+/// Get the shard of the current thread, create it on the first use.
+/// Shards are cache line aligned, so threads never write into the same line.
+/// \return         The shard or NULL, if there is no memory for it. The next call tries again.
+stats_shard_t *_stats_shard() {
+    size_t size = (sizeof(stats_shard_t) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+    if (s_shard)
+        return s_shard;
+
+    pthread_once(&s_shard_key_once, _stats_shard_key_create);
+
+    s_shard = aligned_alloc(CACHE_LINE_SIZE, size);
+    if (!s_shard)
+        return NULL;
+    memset(s_shard, 0, size);
+
+    pthread_mutex_lock(&s_shard_list_mutex);
+    s_shard->next = s_shard_list;
+    s_shard_list = s_shard;
+    pthread_mutex_unlock(&s_shard_list_mutex);
+
+    pthread_setspecific(s_shard_key, s_shard);
+
+    return s_shard;
+}
+
+/// Keep statistics of the finished thread.
+/// \param arg      The shard.
+void _stats_shard_destroy(void *arg) {
+    stats_shard_t *shard = (stats_shard_t *) arg;
+    stats_shard_t **ptr = NULL;
+
+    pthread_mutex_lock(&s_shard_list_mutex);
+
+    for (ptr = &s_shard_list; *ptr; ptr = &(*ptr)->next) {
+        if (*ptr == shard) {
+            *ptr = shard->next;
+            break;
+        }
+    }
+
+    _stats_merge(&s_retired, shard);
+
+    pthread_mutex_unlock(&s_shard_list_mutex);
+
+    if (shard == s_shard)
+        s_shard = NULL;
+
+    free(shard);
+}
+
+/// Add values of the shard to the total.
+/// \param total    The total.
+/// \param shard    The shard. It may be updated by its thread meanwhile.
+void _stats_merge(stats_shard_t *total, stats_shard_t *shard) {
+    int i;
+
+    for (i = 0; i < STATS_COUNTER_COUNT; ++i)
+        total->counters[i] += __atomic_load_n(&shard->counters[i], __ATOMIC_RELAXED);
+
+    for (i = 0; i < STATS_COMMAND_COUNT; ++i) {
+        _stats_histogram_merge(&total->latency[i], &shard->latency[i]);
+        _stats_histogram_merge(&total->send_size[i], &shard->send_size[i]);
+    }
+
+    _stats_histogram_merge(&total->heartbeat_rtt, &shard->heartbeat_rtt);
+}
+
+/// Add values of the histogram to the total.
+/// \param total    The total.
+/// \param histogram The histogram.
+void _stats_histogram_merge(stats_histogram_t *total, stats_histogram_t *histogram) {
+    long max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+    int i;
+
+    total->count += __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+    total->sum += __atomic_load_n(&histogram->sum, __ATOMIC_RELAXED);
+    if (max > total->max)
+        total->max = max;
+
+    for (i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i)
+        total->buckets[i] += __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+}
+
+/// Increase the value only the current thread writes to. Readers may load it at any time.
+/// \param value    The value.
+/// \param amount   The amount.
+void _stats_increase(long *value, long amount) {
+    __atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+/// Bucket of the value. Buckets are linear within each power of 2, so the relative error is bounded.
+/// \param value    The value.
+/// \return         Index of the bucket.
+int _stats_bucket(long value) {
+    int magnitude;
+    int index;
+
+    if (value < (1L << STATS_HISTOGRAM_SUB_BITS))
+        return value < 0 ? 0 : (int) value;
+
+    magnitude = 63 - __builtin_clzl((unsigned long) value) - STATS_HISTOGRAM_SUB_BITS;
+    index = ((magnitude + 1) << STATS_HISTOGRAM_SUB_BITS)
+            + (int) ((value >> magnitude) & ((1L << STATS_HISTOGRAM_SUB_BITS) - 1));
+
+    return index < STATS_HISTOGRAM_BUCKETS ? index : STATS_HISTOGRAM_BUCKETS - 1;
+}
+
+/// The highest value which falls into the bucket.
+/// \param index    Index of the bucket.
+/// \return         The value.
+long _stats_bucket_limit(int index) {
+    int magnitude;
+    long mantissa;
+
+    if (index < (1 << STATS_HISTOGRAM_SUB_BITS))
+        return index;
+
+    magnitude = (index >> STATS_HISTOGRAM_SUB_BITS) - 1;
+    mantissa = (index & ((1 << STATS_HISTOGRAM_SUB_BITS) - 1)) | (1 << STATS_HISTOGRAM_SUB_BITS);
+
+    return ((mantissa + 1) << magnitude) - 1;
+}
+
+/// Record the value into the histogram.
+/// \param histogram The histogram of the current thread.
+/// \param value    The value.
+void _stats_record(stats_histogram_t *histogram, long value) {
+    _stats_increase(&histogram->count, 1);
+    _stats_increase(&histogram->sum, value);
+    _stats_increase(&histogram->buckets[_stats_bucket(value)], 1);
+    if (value > histogram->max)
+        __atomic_store_n(&histogram->max, value, __ATOMIC_RELAXED);
+}
+
+/// Increase the counter.
+/// \param counter  The counter.
+/// \param amount   The amount.
+void stats_add(stats_counter_t counter, long amount) {
+    stats_shard_t *shard = _stats_shard();
+
+    // Out of memory, the value is not counted.
+    if (shard)
+        _stats_increase(&shard->counters[counter], amount);
+}
+
+/// Count a sent message and its size. It is accounted to the request the current thread is processing.
+/// \param size     Sent bytes.
+void stats_sent(long size) {
+    stats_shard_t *shard = _stats_shard();
+
+    if (!shard)
+        return;
+
+    _stats_increase(&shard->counters[STATS_MESSAGES_SENT], 1);
+    if (size > 0) {
+        _stats_increase(&shard->counters[STATS_BYTES_SENT], size);
+        _stats_record(&shard->send_size[s_command], size);
+    }
+}
+
+/// Start measuring the request the current thread is going to process.
+void stats_request_begin() {
+    s_command = STATS_COMMAND_UNKNOWN;
+    clock_gettime(CLOCK_MONOTONIC, &s_request_start);
+}
+
+/// Tell which command the request being processed is.
+/// \param command  The command.
+void stats_request_command(stats_command_t command) {
+    s_command = command;
+}
+
+/// Record the latency of the request being processed.
+void stats_request_end() {
+    stats_shard_t *shard = _stats_shard();
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (shard)
+        _stats_record(&shard->latency[s_command],
+                      (now.tv_sec - s_request_start.tv_sec) * 1000000L + (now.tv_nsec - s_request_start.tv_nsec) / 1000);
+
+    s_command = STATS_COMMAND_SERVER;
+}
+
+/// Record the round trip time of the answered ping.
+/// \param rtt      The time in microseconds.
+void stats_heartbeat_rtt(long rtt) {
+    stats_shard_t *shard = _stats_shard();
+
+    if (shard)
+        _stats_record(&shard->heartbeat_rtt, rtt);
+}
+
+/// Sum statistics of all threads.
+/// \param total    Where the sum is written.
+void stats_collect(stats_shard_t *total) {
+    stats_shard_t *shard = NULL;
+
+    memset(total, 0, sizeof(stats_shard_t));
+
+    pthread_mutex_lock(&s_shard_list_mutex);
+
+    _stats_merge(total, &s_retired);
+    for (shard = s_shard_list; shard; shard = shard->next)
+        _stats_merge(total, shard);
+
+    pthread_mutex_unlock(&s_shard_list_mutex);
+}
+
+/// Value below which the fraction of recorded values falls.
+/// \param histogram The histogram.
+/// \param fraction The fraction (0 .. 1).
+/// \return         Upper limit of the bucket of the value.
+long stats_percentile(stats_histogram_t *histogram, double fraction) {
+    long rank = (long) (fraction * (double) histogram->count + 0.5);
+    long seen = 0;
+    int i;
+
+    if (rank < 1)
+        rank = 1;
+
+    for (i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i) {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+            return _stats_bucket_limit(i) < histogram->max ? _stats_bucket_limit(i) : histogram->max;
+    }
+
+    return histogram->max;
+}
+
+/// Name of the command.
+/// \param command  The command.
+/// \return         The name.
+char *stats_command_name(stats_command_t command) {
+    return s_command_names[command];
+}
 
 /// Prints the info about the connection.
 /// \param stream
 void print_info(FILE *stream) {
+    stats_shard_t *total = NULL;
+    stats_histogram_t *latency = NULL;
+    stats_histogram_t *send_size = NULL;
+    int i;
+
     time(&time_current);
 
     long seconds    = (long) difftime(time_current, time_initial);
     long minutes     = seconds / 60;
     long hours       = minutes / 60;
 
+    total = malloc(sizeof(stats_shard_t));
+    if (!total)
+        return;
+    stats_collect(total);
+
     fprintf(stream, "==================== SERVER STATISTICS ====================\r\n");
     fprintf(stream, "Server started at: %s\r\n", asctime(localtime(&time_initial)));
     fprintf(stream, "Already running: %ld hours %ld minutes %ld seconds\r\n", hours, minutes, seconds%60);
-    fprintf(stream, "Number of recieved messages: %ld\r\n", messages_received);
-    fprintf(stream, "Number of recieved bytes: %ld\r\n", bytes_received);
-    fprintf(stream, "Number of sent messages: %ld\r\n", messages_sent);
-    fprintf(stream, "Number of sent bytes: %ld\r\n", bytes_sent);
-    fprintf(stream, "Number of recieved messages with bad form: %ld\r\n", messages_bad);
+    fprintf(stream, "Number of recieved messages: %ld\r\n", total->counters[STATS_MESSAGES_RECEIVED]);
+    fprintf(stream, "Number of recieved bytes: %ld\r\n", total->counters[STATS_BYTES_RECEIVED]);
+    fprintf(stream, "Number of sent messages: %ld\r\n", total->counters[STATS_MESSAGES_SENT]);
+    fprintf(stream, "Number of sent bytes: %ld\r\n", total->counters[STATS_BYTES_SENT]);
+    fprintf(stream, "Number of recieved messages with bad form: %ld\r\n", total->counters[STATS_MESSAGES_BAD]);
+    fprintf(stream, "Number of dropped log messages: %ld\r\n", g_logger_dropped);
+    fprintf(stream, "Number of refused connections: %ld\r\n", total->counters[STATS_CONNECTIONS_REFUSED]);
+    fprintf(stream, "Number of connections without the handshake in time: %ld\r\n", total->counters[STATS_HANDSHAKE_TIMEOUTS]);
+    fprintf(stream, "Number of connections evicted by the heartbeat: %ld\r\n", total->counters[STATS_HEARTBEAT_EVICTIONS]);
+    if (total->heartbeat_rtt.count > 0)
+        fprintf(stream, "Heartbeat: %ld pongs, round trip p50 %ld us, p99 %ld us, max %ld us\r\n", total->heartbeat_rtt.count,
+                stats_percentile(&total->heartbeat_rtt, 0.5), stats_percentile(&total->heartbeat_rtt, 0.99), total->heartbeat_rtt.max);
+
+    for (i = 0; i < STATS_COMMAND_COUNT; ++i) {
+        latency = &total->latency[i];
+        send_size = &total->send_size[i];
+
+        if (latency->count == 0 && send_size->count == 0)
+            continue;
+
+        fprintf(stream, "Command %s:\r\n", s_command_names[i]);
+        if (latency->count > 0)
+            fprintf(stream, "\tRequests: %ld, latency p50 %ld us, p99 %ld us, max %ld us\r\n", latency->count,
+                    stats_percentile(latency, 0.5), stats_percentile(latency, 0.99), latency->max);
+        if (send_size->count > 0)
+            fprintf(stream, "\tSent messages: %ld, size p50 %ld B, p99 %ld B, max %ld B\r\n", send_size->count,
+                    stats_percentile(send_size, 0.5), stats_percentile(send_size, 0.99), send_size->max);
+    }
+
     fprintf(stream, "===========================================================\r\n");
+
+    free(total);
 }
 
-/// Write down message into log file and console.
+/// Write down message into log file and console. The message is queued, the logger thread writes it down.
 /// \param log
 void write_log(char *log) {
-    FILE *logs = fopen("server.log", "a");
-    fprintf(logs, "%s\t%s\r\n", asctime(localtime(&time_initial)), log);
-    fprintf(stdout, "%s", log);
-    fclose(logs);
+    logger_write(log);
 }
 
 /// Write down statistics into stats file.
@@ -48,4 +353,4 @@ void write_stats() {
     FILE *f = fopen("stats.log", "w");
     print_info(f);
     fclose(f);
-}
\ No newline at end of file
+}
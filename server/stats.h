@@ -6,12 +6,25 @@
 #define SERVER_STATS_H
 
 extern time_t time_initial, time_current;
-extern long bytes_received;
-extern long bytes_sent;
-extern long messages_received;
-extern long messages_sent;
-extern long messages_bad;
 
+void _stats_shard_key_create();
+stats_shard_t *_stats_shard();
+void _stats_shard_destroy(void *arg);
+void _stats_merge(stats_shard_t *total, stats_shard_t *shard);
+void _stats_histogram_merge(stats_histogram_t *total, stats_histogram_t *histogram);
+void _stats_increase(long *value, long amount);
+int _stats_bucket(long value);
+long _stats_bucket_limit(int index);
+void _stats_record(stats_histogram_t *histogram, long value);
+void stats_add(stats_counter_t counter, long amount);
+void stats_sent(long size);
+void stats_request_begin();
+void stats_request_command(stats_command_t command);
+void stats_request_end();
+void stats_heartbeat_rtt(long rtt);
+void stats_collect(stats_shard_t *total);
+long stats_percentile(stats_histogram_t *histogram, double fraction);
+char *stats_command_name(stats_command_t command);
 void print_info(FILE *stream);
 void write_log(char *log);
 void write_stats();
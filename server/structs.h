@@ -5,8 +5,102 @@
 #ifndef SERVER_STRUCTS_H
 #define SERVER_STRUCTS_H
 
-#include <semaphore.h>
+#include <time.h>
+#include <pthread.h>
 #include <netinet/in.h>
+#include "constants.h"
+
+typedef struct thememoryblock {
+    struct thememoryblock *next;
+} memory_block_t;
+
+typedef struct thememorycache {
+    memory_block_t *free[MEMORY_CLASS_COUNT];
+    long count[MEMORY_CLASS_COUNT];
+    long allocations[MEMORY_CLASS_COUNT + 1];
+    long frees[MEMORY_CLASS_COUNT + 1];
+    struct thememorycache *next;
+} memory_cache_t;
+
+typedef enum thestatscounter {
+    STATS_BYTES_RECEIVED = 0,
+    STATS_BYTES_SENT,
+    STATS_MESSAGES_RECEIVED,
+    STATS_MESSAGES_SENT,
+    STATS_MESSAGES_BAD,
+    STATS_HEARTBEAT_EVICTIONS,
+    STATS_CONNECTIONS_REFUSED,
+    STATS_HANDSHAKE_TIMEOUTS,
+    STATS_COUNTER_COUNT,
+} stats_counter_t;
+
+typedef enum thestatscommand {
+    STATS_COMMAND_SERVER = 0, // Messages sent on the server's own initiative.
+    STATS_COMMAND_UNKNOWN,
+    STATS_COMMAND_PLAYER_NICKNAME, // Commands are in the order of the token list, as token_t is.
+    STATS_COMMAND_PLAYER_RECONNECT,
+    STATS_COMMAND_GET_GAMES,
+    STATS_COMMAND_LOBBY_SUBSCRIBE,
+    STATS_COMMAND_CREATE_NEW_GAME,
+    STATS_COMMAND_JOIN_PLAYER_TO_GAME,
+    STATS_COMMAND_DISCONNECT_PLAYER,
+    STATS_COMMAND_DISCONNECT_PLAYER_FROM_GAME,
+    STATS_COMMAND_GAME_CHOICE_SELECTED,
+    STATS_COMMAND_PONG,
+    STATS_COMMAND_COUNT,
+} stats_command_t;
+
+typedef struct thestatshistogram {
+    long count;
+    long sum;
+    long max;
+    long buckets[STATS_HISTOGRAM_BUCKETS];
+} stats_histogram_t;
+
+typedef struct thestatsshard {
+    long counters[STATS_COUNTER_COUNT];
+    stats_histogram_t latency[STATS_COMMAND_COUNT]; // Microseconds from receiving a request to finishing it.
+    stats_histogram_t send_size[STATS_COMMAND_COUNT]; // Bytes.
+    stats_histogram_t heartbeat_rtt; // Microseconds from sending a ping until its pong is received.
+    struct thestatsshard *next;
+} stats_shard_t;
+
+typedef enum themetricsgauge {
+    METRICS_GAUGE_PLAYERS = 0,
+    METRICS_GAUGE_PLAYERS_CONNECTED,
+    METRICS_GAUGE_GAMES,
+    METRICS_GAUGE_GAMES_IN_PROGRESS,
+    METRICS_GAUGE_OPEN_SLOTS,
+    METRICS_GAUGE_COUNT,
+} metrics_gauge_t;
+
+typedef struct thelogentry {
+    unsigned long sequence;
+    struct timespec time;
+    unsigned int length;
+    char text[LOGGER_ENTRY_SIZE];
+} log_entry_t;
+
+typedef struct thebuffer {
+    int reference_count;
+    size_t length;
+    char data[]; // Null-terminated.
+} buffer_t;
+
+typedef struct themessage {
+    char *data;
+    size_t length;
+    size_t capacity;
+    size_t header; // Bytes reserved in front of the data for the buffer header.
+} message_t;
+
+typedef struct thetable {
+    void **slots;
+    unsigned int capacity;
+    unsigned int count;
+    unsigned int used;
+    char *(*key)(void *item);
+} table_t;
 
 typedef enum thechoice {
     ROCK        = 1,
@@ -14,36 +108,255 @@ typedef enum thechoice {
     SCISSORS    = 3,
 } choice_t;
 
+typedef enum thelobbymode {
+    LOBBY_MODE_SNAPSHOT = 0,
+    LOBBY_MODE_DELTA    = 1,
+} lobby_mode_t;
+
+typedef struct thelobbysend {
+    struct theplayer *player; // Held until the update is sent.
+    int is_snapshot;
+    int is_delta_mode;
+    size_t offset; // Where the deltas of the subscriber start.
+} lobby_send_t;
+
+typedef struct thetimerentry {
+    void (*expire)(struct thetimerentry *timer);
+    void *data;
+    unsigned long deadline; // Tick.
+    int is_pending;
+    struct thetimerentry **slot;
+    struct thetimerentry *next;
+    struct thetimerentry *prev;
+} timer_entry_t;
+
 typedef struct theplayer {
-    int socket;
-    char *id;
+    char id[ID_LENGTH + 1];
     int is_disconnected;
-    char *nickname;
-    char *client_addr;
+    char nickname[NICKNAME_LENGTH + 1];
+    int nickname_length;
+    char client_addr[INET_ADDRSTRLEN];
     char *color;
     int score;
     int choice;
-    struct theplayer *next;
+    struct theplayer *addr_next;
+    struct theplayer *addr_prev;
+    int is_subscribed;
+    lobby_mode_t lobby_mode;
+    long lobby_version;
+    struct theplayer *lobby_next;
+    struct theplayer *lobby_prev;
     struct thegame *game;
+    struct theconnection *connection;
+    pthread_mutex_t mutex; // Guards the connection, the game and the removal.
+    int reference_count;
+    int is_removed;
+    time_t lost_at;
+    timer_entry_t lost_timer; // Pending while the player is lost, the player is removed when it expires.
+    struct theplayer *expired_next;
+    int is_expired; // Queued for the sweep, guarded by the expired list mutex.
 
 } player_t;
 
+typedef struct theslice {
+    char *data;
+    unsigned int length;
+} slice_t;
+
+typedef struct therequest {
+    slice_t tokens[MAX_CLIENT_TOKENS];
+    int count;
+    int command; // The command token (token_t), TOKEN_COUNT if it is not a command.
+    char storage[REQUEST_STORAGE_SIZE]; // Text of the tokens decoded from a binary frame.
+} request_t;
+
+typedef int (*request_handler_t)(player_t *player, request_t *request);
+
+typedef struct thetask {
+    void (*run)(struct thetask *task);
+    void (*release)(struct thetask *task);
+    void *owner;
+    int event;
+    void *data;
+    long value;
+    timer_entry_t timer;
+    struct thestrand *strand;
+    struct thetask *next;
+} task_t;
+
+typedef struct thestrand {
+    pthread_mutex_t mutex;
+    task_t *head;
+    task_t *tail;
+    int is_scheduled;
+    int shard; // The shard whose reactor thread runs the tasks.
+    struct thestrand *run_next;
+} strand_t;
+
+typedef struct theschedulershard {
+    pthread_mutex_t mutex;
+    strand_t *run_list; // Strands with pending tasks, in the order they are going to be served.
+    strand_t *run_list_tail;
+    int event_fd; // Signalled when the run list stops being empty.
+} scheduler_shard_t;
+
+typedef enum thegameevent {
+    GAME_EVENT_ROUND_START = 0,
+    GAME_EVENT_CHOICE,
+    GAME_EVENT_ROUND_EVALUATED,
+    GAME_EVENT_STOP,
+    GAME_EVENT_JOIN,
+    GAME_EVENT_LEAVE,
+} game_event_t;
+
+typedef enum thegamestate {
+    GAME_STATE_WAITING = 0,
+    GAME_STATE_ON_TURN,
+    GAME_STATE_REVEAL,
+    GAME_STATE_OVER,
+} game_state_t;
+
 typedef struct thegame {
-    char *id;
-    char *name;
+    char id[ID_LENGTH + 1];
+    char name[ID_LENGTH + 5 + 1];
     int goal;
     player_t *players[2];
     int player_count;
     int in_progress;
-    pthread_t thread;
-    sem_t sem_on_turn;
-    struct thegame *next;
+    game_state_t state;
+    strand_t strand; // Players join and leave by events, so only the strand touches the players of the game.
+    int reference_count;
+    int is_open;
+    int open_slots;
+    struct thegame *open_next;
+    struct thegame *open_prev;
+    size_t lobby_offset;
+    size_t lobby_length;
 } game_t;
 
-typedef struct theremoteconnection {
-    char *client_address;
-    int client_address_len;
-    int client_socket;
-} remote_connection_t;
+typedef enum theconnectionstate {
+    CONNECTION_HANDSHAKE    = 0,
+    CONNECTION_ACTIVE       = 1,
+} connection_state_t;
+
+typedef enum theprotocol {
+    PROTOCOL_TEXT           = 0, // Messages "id;command;args" terminated by '\n'.
+    PROTOCOL_BINARY         = 1, // Frames prefixed by the varint length, negotiated in the handshake.
+} protocol_t;
+
+typedef struct theframebuffer {
+    char data[RECEIVE_BUFFER_SIZE];
+    unsigned int head;
+    unsigned int tail;
+    unsigned int scanned;
+} frame_buffer_t;
+
+typedef struct theoutputchunk {
+    struct theoutputchunk *next;
+    buffer_t *buffer;
+    char *data; // Unsent part of the buffer.
+    size_t length;
+} output_chunk_t;
+
+typedef struct theconnection {
+    int socket;
+    connection_state_t state;
+    protocol_t protocol;
+    frame_buffer_t input;
+    pthread_mutex_t output_mutex;
+    output_chunk_t *output_head;
+    output_chunk_t *output_tail;
+    size_t output_length; // Queued bytes which are not sent yet.
+    int is_closed;
+    int is_broken;
+    int reference_count;
+    char client_address[INET_ADDRSTRLEN];
+    struct theplayer *player; // Held by the connection, guarded by the output mutex.
+    struct thereactor *reactor;
+    time_t accepted_at;
+    time_t last_activity;
+    int timeout_unsuccessful;
+    timer_entry_t heartbeat_timer; // Sends the next ping or expires the unanswered one. It holds a reference while pending.
+    unsigned long ping_sequence; // Heartbeat state is guarded by the output mutex.
+    long ping_sent_at; // Monotonic microseconds, 0 if the last ping is answered.
+    int ping_misses;
+    int has_pong; // Only peers which answered a ping are evicted, older clients are left to the idle timeout.
+    int is_evicted;
+    long rtt_smoothed; // Microseconds.
+    long rtt_variance;
+    struct theconnection *prev;
+    struct theconnection *next;
+} connection_t;
+
+typedef struct thereactor {
+    int index;
+    int epoll_fd;
+    int listen_socket; // -1 if connections are accepted by the accept thread.
+    int is_running;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    connection_t *connection_list;
+    long connection_count;
+    long handshake_count; // Connections which did not finish the handshake yet.
+    time_t last_sweep;
+} reactor_t;
+
+typedef struct theadmindump {
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    int pending; // Copies posted to strands which are not released yet.
+    long epoch;
+} admin_dump_t;
+
+typedef struct theadminplayer {
+    char id[ID_LENGTH + 1];
+    char nickname[NICKNAME_LENGTH + 1];
+    char client_addr[INET_ADDRSTRLEN];
+    char game_id[ID_LENGTH + 1]; // Empty if the player is in the lobby.
+    int is_disconnected;
+    int is_connected;
+    int is_lost;
+    int is_removed;
+} admin_player_t;
+
+typedef struct theadminseat {
+    char id[ID_LENGTH + 1]; // Empty if the seat is free.
+    int score;
+    int choice;
+} admin_seat_t;
+
+typedef struct theadmingame {
+    struct thegame *game; // Held until the copy task is released.
+    int is_copied; // 0 if the game was stopped before its strand copied it.
+    char id[ID_LENGTH + 1];
+    char name[ID_LENGTH + 5 + 1];
+    int goal;
+    game_state_t state;
+    int in_progress;
+    int is_open;
+    int player_count;
+    admin_seat_t seats[PLAYER_COUNT];
+} admin_game_t;
+
+typedef struct theadminsocket {
+    int socket;
+    char client_address[INET_ADDRSTRLEN];
+    char player_id[ID_LENGTH + 1]; // Empty until the handshake is done.
+    connection_state_t state;
+    protocol_t protocol;
+    size_t output_length;
+    int is_broken;
+    time_t accepted_at;
+    time_t last_activity;
+    int has_pong;
+    int ping_misses;
+    long rtt_smoothed;
+} admin_socket_t;
+
+typedef struct theadminreactor {
+    reactor_t *reactor;
+    admin_socket_t *sockets;
+    long count;
+} admin_reactor_t;
 
 #endif //SERVER_STRUCTS_H
@@ -0,0 +1,168 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "structs.h"
+#include "table.h"
+#include "memory.h"
+
+// Marks a slot of a removed item, so probing does not stop there.
+static char t_tombstone;
+
+#define TABLE_TOMBSTONE ((void *) &t_tombstone)
+#define TABLE_CAPACITY_DEFAULT 64
+
+/// Initialize an empty open-addressing hash table.
+/// \param table    The table.
+/// \param key      Function which returns the key of an item.
+void table_init(table_t *table, char *(*key)(void *item)) {
+    table->slots = NULL;
+    table->capacity = 0;
+    table->count = 0;
+    table->used = 0;
+    table->key = key;
+}
+
+/// FNV-1a hash of the key.
+/// \param key      The key.
+/// \return         The hash.
+unsigned long table_hash(char *key) {
+    unsigned long hash = 14695981039346656037UL;
+
+    while (*key) {
+        hash ^= (unsigned char) *key++;
+        hash *= 1099511628211UL;
+    }
+
+    return hash;
+}
+
+/// Find an item by the key.
+/// \param table    The table.
+/// \param key      The key.
+/// \return         The item or NULL.
+void *table_find(table_t *table, char *key) {
+    if (!table->capacity || !key)
+        return NULL;
+
+    unsigned int mask = table->capacity - 1;
+    unsigned int i = (unsigned int) table_hash(key) & mask;
+    void *item = NULL;
+
+    while ((item = table->slots[i]) != NULL) {
+        if (item != TABLE_TOMBSTONE && strcmp(table->key(item), key) == 0)
+            return item;
+
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+/// Add an item into the table. The table grows if it is half full.
+/// \param table    The table.
+/// \param item     The item.
+void table_add(table_t *table, void *item) {
+    if (!item)
+        return;
+
+    unsigned int mask;
+    unsigned int i;
+
+    if ((table->used + 1) * 2 > table->capacity)
+        _table_resize(table, table->count * 4 > TABLE_CAPACITY_DEFAULT ? table->count * 4 : TABLE_CAPACITY_DEFAULT);
+
+    mask = table->capacity - 1;
+    i = (unsigned int) table_hash(table->key(item)) & mask;
+
+    while (table->slots[i] != NULL && table->slots[i] != TABLE_TOMBSTONE)
+        i = (i + 1) & mask;
+
+    if (table->slots[i] == NULL)
+        table->used++;
+
+    table->slots[i] = item;
+    table->count++;
+}
+
+/// Remove the item from the table.
+/// \param table    The table.
+/// \param item     The item.
+/// \return         1 = Removed, 0 = The item is not in the table.
+int table_remove(table_t *table, void *item) {
+    if (!table->capacity || !item)
+        return 0;
+
+    unsigned int mask = table->capacity - 1;
+    unsigned int i = (unsigned int) table_hash(table->key(item)) & mask;
+
+    while (table->slots[i] != NULL) {
+        if (table->slots[i] == item) {
+            // The slot can be emptied if it does not break any probe chain.
+            if (table->slots[(i + 1) & mask] == NULL) {
+                table->slots[i] = NULL;
+                table->used--;
+            } else {
+                table->slots[i] = TABLE_TOMBSTONE;
+            }
+
+            table->count--;
+            return 1;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+/// Iterate over items of the table.
+/// \param table    The table.
+/// \param index    Iteration state, set it to 0 before the first call.
+/// \return         The next item or NULL at the end.
+void *table_iterate(table_t *table, unsigned int *index) {
+    void *item = NULL;
+
+    while (*index < table->capacity) {
+        item = table->slots[(*index)++];
+
+        if (item != NULL && item != TABLE_TOMBSTONE)
+            return item;
+    }
+
+    return NULL;
+}
+
+/// Rebuild the table with a new capacity. Drops all tombstones.
+/// \param table        The table.
+/// \param capacity     Minimal new capacity.
+void _table_resize(table_t *table, unsigned int capacity) {
+    void **slots = table->slots;
+    unsigned int old_capacity = table->capacity;
+    unsigned int i;
+
+    // Capacity has to be a power of 2.
+    table->capacity = TABLE_CAPACITY_DEFAULT;
+    while (table->capacity < capacity)
+        table->capacity <<= 1;
+
+    table->slots = memory_malloc(sizeof(void *) * table->capacity, 0);
+    memset(table->slots, 0, sizeof(void *) * table->capacity);
+    table->count = 0;
+    table->used = 0;
+
+    for (i = 0; i < old_capacity; ++i)
+        if (slots[i] != NULL && slots[i] != TABLE_TOMBSTONE)
+            table_add(table, slots[i]);
+
+    memory_free(slots, 0);
+}
+
+/// Free the table. Items are not freed.
+/// \param table    The table.
+void table_free(table_t *table) {
+    memory_free(table->slots, 0);
+    table_init(table, table->key);
+}
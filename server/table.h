@@ -0,0 +1,17 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_TABLE_H
+#define SERVER_TABLE_H
+
+void table_init(table_t *table, char *(*key)(void *item));
+unsigned long table_hash(char *key);
+void *table_find(table_t *table, char *key);
+void table_add(table_t *table, void *item);
+int table_remove(table_t *table, void *item);
+void *table_iterate(table_t *table, unsigned int *index);
+void _table_resize(table_t *table, unsigned int capacity);
+void table_free(table_t *table);
+
+#endif //SERVER_TABLE_H
@@ -0,0 +1,306 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "constants.h"
+#include "structs.h"
+#include "timer.h"
+
+#define TIMER_SLOT_COUNT (1 << TIMER_SLOT_BITS)
+#define TIMER_SLOT_MASK (TIMER_SLOT_COUNT - 1)
+
+// Wheels of the levels. Level 0 has a slot for each tick, each next level has slots which are TIMER_SLOT_COUNT times longer.
+timer_entry_t *t_wheel[TIMER_LEVEL_COUNT][TIMER_SLOT_COUNT];
+
+// The tick the wheel is at and the time of tick 0.
+unsigned long t_now = 0;
+struct timespec t_start;
+
+long t_pending = 0;
+int t_is_running = 0;
+pthread_mutex_t t_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t t_condition;
+pthread_t t_thread;
+
+/// Start the timer thread.
+void timer_init() {
+    pthread_condattr_t attributes;
+
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&t_condition, &attributes);
+    pthread_condattr_destroy(&attributes);
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    t_is_running = 1;
+
+    if (pthread_create(&t_thread, NULL, _timer_serve, NULL)) {
+        printf("\t> Timer thread: ERROR!\n");
+        exit(1);
+    }
+}
+
+/// Initialize the timer entry.
+/// \param timer    The timer entry.
+/// \param expire   Function called on the timer thread when the timer expires. It must not block.
+/// \param data     Data of the owner.
+void timer_entry_init(timer_entry_t *timer, void (*expire)(timer_entry_t *timer), void *data) {
+    timer->expire = expire;
+    timer->data = data;
+    timer->deadline = 0;
+    timer->is_pending = 0;
+    timer->slot = NULL;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/// Ticks elapsed since the timer thread started.
+/// \return         The tick.
+unsigned long _timer_current_tick() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (unsigned long) ((now.tv_sec - t_start.tv_sec) * 1000L + (now.tv_nsec - t_start.tv_nsec) / 1000000L) / TIMER_TICK;
+}
+
+/// Put the timer into the slot its deadline falls into. Call it with the timer mutex.
+/// \param timer    The timer entry.
+void _timer_link(timer_entry_t *timer) {
+    unsigned long delta = timer->deadline - t_now;
+    timer_entry_t **slot = NULL;
+    int level = 0;
+
+    // The farther the deadline, the coarser the level.
+    while (level < TIMER_LEVEL_COUNT - 1 && delta >= (1UL << (TIMER_SLOT_BITS * (level + 1))))
+        level++;
+
+    // Deadlines beyond the last level wait in its farthest slot and are placed again later.
+    if (delta >= (1UL << (TIMER_SLOT_BITS * TIMER_LEVEL_COUNT)))
+        slot = &t_wheel[level][((t_now >> (TIMER_SLOT_BITS * level)) - 1) & TIMER_SLOT_MASK];
+    else
+        slot = &t_wheel[level][(timer->deadline >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK];
+
+    timer->slot = slot;
+    timer->prev = NULL;
+    timer->next = *slot;
+    if (*slot)
+        (*slot)->prev = timer;
+    *slot = timer;
+}
+
+/// Take the timer out of its slot. Call it with the timer mutex.
+/// \param timer    The timer entry.
+void _timer_unlink(timer_entry_t *timer) {
+    if (timer->prev)
+        timer->prev->next = timer->next;
+    else
+        *timer->slot = timer->next;
+
+    if (timer->next)
+        timer->next->prev = timer->prev;
+
+    timer->slot = NULL;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/// Schedule the timer. A pending timer is rescheduled.
+/// \param timer    The timer entry.
+/// \param delay    The delay in milliseconds.
+void timer_schedule(timer_entry_t *timer, long delay) {
+    unsigned long ticks = delay > 0 ? (unsigned long) (delay + TIMER_TICK - 1) / TIMER_TICK : 0;
+    unsigned long tick;
+
+    pthread_mutex_lock(&t_mutex);
+
+    if (timer->is_pending) {
+        _timer_unlink(timer);
+        t_pending--;
+    }
+
+    // An empty wheel does not tick, catch up with the time first.
+    tick = _timer_current_tick();
+    if (t_pending == 0)
+        t_now = tick;
+
+    // The current tick is being fired or already fired, the nearest is the next one.
+    timer->deadline = tick + ticks > t_now ? tick + ticks : t_now + 1;
+    timer->is_pending = 1;
+    _timer_link(timer);
+
+    if (t_pending++ == 0)
+        pthread_cond_signal(&t_condition);
+
+    pthread_mutex_unlock(&t_mutex);
+}
+
+/// Cancel the timer.
+/// \param timer    The timer entry.
+/// \return         1 = Cancelled, 0 = It is not pending, it may be just expiring.
+int timer_cancel(timer_entry_t *timer) {
+    int is_cancelled = 0;
+
+    pthread_mutex_lock(&t_mutex);
+
+    if (timer->is_pending) {
+        _timer_unlink(timer);
+        timer->is_pending = 0;
+        t_pending--;
+        is_cancelled = 1;
+    }
+
+    pthread_mutex_unlock(&t_mutex);
+
+    return is_cancelled;
+}
+
+/// Check if the timer is pending.
+/// \param timer    The timer entry.
+/// \return         1 = Pending, 0 = Not pending, it may be just expiring.
+int timer_is_pending(timer_entry_t *timer) {
+    int is_pending;
+
+    pthread_mutex_lock(&t_mutex);
+    is_pending = timer->is_pending;
+    pthread_mutex_unlock(&t_mutex);
+
+    return is_pending;
+}
+
+/// Move timers of the slot of the higher level to lower levels. Call it with the timer mutex.
+/// \param level    The level.
+void _timer_cascade(int level) {
+    timer_entry_t **slot = &t_wheel[level][(t_now >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK];
+    timer_entry_t *timer = *slot;
+    timer_entry_t *next = NULL;
+
+    *slot = NULL;
+
+    for (; timer; timer = next) {
+        next = timer->next;
+        _timer_link(timer);
+    }
+}
+
+/// Advance the wheel by one tick. Call it with the timer mutex.
+/// \param expired  List where the expired timers are appended.
+void _timer_tick(timer_entry_t **expired) {
+    timer_entry_t **slot = NULL;
+    timer_entry_t *timer = NULL;
+    int level;
+
+    t_now++;
+
+    // Each time a level goes round, the next slot of the higher level is spread over the lower ones.
+    for (level = 1; level < TIMER_LEVEL_COUNT; ++level) {
+        if (t_now & ((1UL << (TIMER_SLOT_BITS * level)) - 1))
+            break;
+        _timer_cascade(level);
+    }
+
+    slot = &t_wheel[0][t_now & TIMER_SLOT_MASK];
+
+    while ((timer = *slot)) {
+        *slot = timer->next;
+        timer->is_pending = 0;
+        timer->slot = NULL;
+        timer->prev = NULL;
+        timer->next = *expired;
+        *expired = timer;
+        t_pending--;
+    }
+}
+
+/// Fire the expired timers. Timers are fired without the mutex, so they may schedule timers.
+/// \param expired  The expired timers.
+void _timer_fire(timer_entry_t *expired) {
+    timer_entry_t *next = NULL;
+
+    for (; expired; expired = next) {
+        next = expired->next;
+        expired->next = NULL;
+        expired->expire(expired);
+    }
+}
+
+/// Tick while there are pending timers. The thread sleeps while the wheel is empty.
+/// \param arg      Unused.
+void *_timer_serve(void *arg) {
+    timer_entry_t *expired = NULL;
+    struct timespec next_tick;
+    unsigned long tick;
+
+    pthread_mutex_lock(&t_mutex);
+
+    while (t_is_running) {
+        if (t_pending == 0) {
+            pthread_cond_wait(&t_condition, &t_mutex);
+            continue;
+        }
+
+        // Catch up with the time, the thread may have been late.
+        tick = _timer_current_tick();
+        expired = NULL;
+
+        while (t_now < tick && t_pending > 0)
+            _timer_tick(&expired);
+
+        if (expired) {
+            pthread_mutex_unlock(&t_mutex);
+            _timer_fire(expired);
+            pthread_mutex_lock(&t_mutex);
+            continue;
+        }
+
+        next_tick.tv_sec = t_start.tv_sec + (long) ((t_now + 1) * TIMER_TICK / 1000);
+        next_tick.tv_nsec = t_start.tv_nsec + (long) ((t_now + 1) * TIMER_TICK % 1000) * 1000000L;
+        if (next_tick.tv_nsec >= 1000000000L) {
+            next_tick.tv_sec++;
+            next_tick.tv_nsec -= 1000000000L;
+        }
+
+        pthread_cond_timedwait(&t_condition, &t_mutex, &next_tick);
+    }
+
+    pthread_mutex_unlock(&t_mutex);
+
+    return NULL;
+}
+
+/// Stop the timer thread. Pending timers are fired at once, so their owners can release what they hold.
+void timer_free() {
+    timer_entry_t *expired = NULL;
+    timer_entry_t *timer = NULL;
+    int level;
+    int index;
+
+    pthread_mutex_lock(&t_mutex);
+    t_is_running = 0;
+    pthread_cond_signal(&t_condition);
+    pthread_mutex_unlock(&t_mutex);
+
+    pthread_join(t_thread, NULL);
+
+    for (level = 0; level < TIMER_LEVEL_COUNT; ++level) {
+        for (index = 0; index < TIMER_SLOT_COUNT; ++index) {
+            while ((timer = t_wheel[level][index])) {
+                t_wheel[level][index] = timer->next;
+                timer->is_pending = 0;
+                timer->slot = NULL;
+                timer->prev = NULL;
+                timer->next = expired;
+                expired = timer;
+            }
+        }
+    }
+    t_pending = 0;
+
+    _timer_fire(expired);
+
+    pthread_cond_destroy(&t_condition);
+}
@@ -0,0 +1,22 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#ifndef SERVER_TIMER_H
+#define SERVER_TIMER_H
+
+void timer_init();
+void timer_entry_init(timer_entry_t *timer, void (*expire)(timer_entry_t *timer), void *data);
+unsigned long _timer_current_tick();
+void _timer_link(timer_entry_t *timer);
+void _timer_unlink(timer_entry_t *timer);
+void timer_schedule(timer_entry_t *timer, long delay);
+int timer_cancel(timer_entry_t *timer);
+int timer_is_pending(timer_entry_t *timer);
+void _timer_cascade(int level);
+void _timer_tick(timer_entry_t **expired);
+void _timer_fire(timer_entry_t *expired);
+void *_timer_serve(void *arg);
+void timer_free();
+
+#endif //SERVER_TIMER_H
@@ -0,0 +1,189 @@
+//
+// Created by Frixs on 17.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Tokens the server accepts, they are listed in this section of the token list.
+#define TOKENGEN_SECTION "S <<<--- C"
+#define TOKENGEN_MAX_TOKENS 64
+#define TOKENGEN_MAX_LENGTH 64
+
+char g_tokens[TOKENGEN_MAX_TOKENS][TOKENGEN_MAX_LENGTH];
+int g_token_count = 0;
+
+/// Seeded FNV-1a hash of the token. The parser uses the same one (_parser_hash).
+/// \param data     The token.
+/// \param length   Length of the token.
+/// \param seed     The seed.
+/// \return         The hash.
+unsigned int _tokengen_hash(const char *data, unsigned int length, unsigned int seed) {
+    unsigned int hash = 2166136261u ^ seed;
+    unsigned int i;
+
+    for (i = 0; i < length; ++i) {
+        hash ^= (unsigned char) data[i];
+        hash *= 16777619u;
+    }
+
+    // Low bits of FNV depend on low bits only, mix the high ones in, so the seed counts.
+    return hash ^ (hash >> 16);
+}
+
+/// Read the tokens of the server section of the token list.
+/// \param path     Path to the token list.
+/// \return         Status code. 0 = Success, 1 = Error.
+int _tokengen_read(char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    size_t length;
+    int is_section = 0;
+
+    if (!f)
+        return 1;
+
+    while (fgets(line, sizeof(line), f)) {
+        length = strlen(line);
+        while (length > 0 && isspace((unsigned char) line[length - 1]))
+            line[--length] = '\0';
+
+        if (!is_section) {
+            is_section = strcmp(line, TOKENGEN_SECTION) == 0;
+            continue;
+        }
+
+        // The section ends by an empty line.
+        if (length == 0)
+            break;
+        if (line[0] == '=')
+            continue;
+
+        if (g_token_count == TOKENGEN_MAX_TOKENS || length >= TOKENGEN_MAX_LENGTH) {
+            fclose(f);
+            return 1;
+        }
+
+        strcpy(g_tokens[g_token_count++], line);
+    }
+
+    fclose(f);
+
+    return g_token_count > 0 ? 0 : 1;
+}
+
+/// Find the seed, with which no two tokens fall into the same slot.
+/// \param size     Count of the slots, a power of 2.
+/// \param seed     Where the seed is written.
+/// \return         Status code. 0 = Found, 1 = Not found.
+int _tokengen_search(unsigned int size, unsigned int *seed) {
+    int slots[TOKENGEN_MAX_TOKENS * 4];
+    unsigned int s;
+    unsigned int slot;
+    int i;
+
+    for (s = 0; s < (1u << 20); ++s) {
+        memset(slots, 0, sizeof(slots));
+
+        for (i = 0; i < g_token_count; ++i) {
+            slot = _tokengen_hash(g_tokens[i], (unsigned int) strlen(g_tokens[i]), s) & (size - 1);
+            if (slots[slot]++)
+                break;
+        }
+
+        if (i == g_token_count) {
+            *seed = s;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/// Write the header with the token enum and the perfect hash table.
+/// \param path     Path to the header.
+/// \param size     Count of the slots.
+/// \param seed     The seed.
+/// \return         Status code. 0 = Success, 1 = Error.
+int _tokengen_write(char *path, unsigned int size, unsigned int seed) {
+    FILE *f = fopen(path, "w");
+    unsigned int slot;
+    int i, j;
+    char c;
+
+    if (!f)
+        return 1;
+
+    fprintf(f, "//\n// Generated from the token list by tokengen. Do not edit.\n//\n\n");
+    fprintf(f, "#ifndef SERVER_TOKEN_HASH_H\n#define SERVER_TOKEN_HASH_H\n\n");
+    fprintf(f, "#define TOKEN_HASH_SEED %uu\n#define TOKEN_HASH_SIZE %u\n\n", seed, size);
+
+    fprintf(f, "typedef enum thetoken {\n");
+    for (i = 0; i < g_token_count; ++i) {
+        fprintf(f, "    TOKEN_");
+        for (j = 0; (c = g_tokens[i][j]); ++j)
+            if (j > 0 || c != '_')
+                fputc(toupper((unsigned char) c), f);
+        fprintf(f, i == 0 ? " = 0,\n" : ",\n");
+    }
+    fprintf(f, "    TOKEN_COUNT,\n} token_t;\n\n");
+
+    fprintf(f, "#define TOKEN_NAMES {");
+    for (i = 0; i < g_token_count; ++i)
+        fprintf(f, "%s\"%s\"", i ? ", " : "", g_tokens[i]);
+    fprintf(f, "}\n\n");
+
+    // Slots hold the token, TOKEN_COUNT means an empty slot.
+    fprintf(f, "#define TOKEN_HASH_SLOTS {");
+    for (slot = 0; slot < size; ++slot) {
+        for (i = 0; i < g_token_count; ++i)
+            if ((_tokengen_hash(g_tokens[i], (unsigned int) strlen(g_tokens[i]), seed) & (size - 1)) == slot)
+                break;
+        fprintf(f, "%s%d", slot ? ", " : "", i);
+    }
+    fprintf(f, "}\n\n");
+
+    fprintf(f, "#endif //SERVER_TOKEN_HASH_H\n");
+
+    return fclose(f) ? 1 : 0;
+}
+
+/// Generate the perfect hash of the tokens the server accepts.
+/// \param argv -
+/// \param args Path to the token list and path to the generated header.
+/// \return Status code of success.
+int main(int argv, char *args[]) {
+    unsigned int size = 1;
+    unsigned int seed = 0;
+
+    if (argv != 3) {
+        fprintf(stderr, "Usage: %s token_list.txt token_hash.h\n", args[0]);
+        return 1;
+    }
+
+    if (_tokengen_read(args[1])) {
+        fprintf(stderr, "\t> Token list: ERROR!\n");
+        return 1;
+    }
+
+    while (size < (unsigned int) g_token_count)
+        size *= 2;
+
+    // Grow the table until a seed is found.
+    while (_tokengen_search(size, &seed)) {
+        size *= 2;
+        if (size > TOKENGEN_MAX_TOKENS * 4) {
+            fprintf(stderr, "\t> Perfect hash: ERROR!\n");
+            return 1;
+        }
+    }
+
+    if (_tokengen_write(args[2], size, seed)) {
+        fprintf(stderr, "\t> Token hash: ERROR during writing!\n");
+        return 1;
+    }
+
+    return 0;
+}